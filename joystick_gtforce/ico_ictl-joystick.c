@@ -20,19 +20,63 @@
 #include    <errno.h>
 #include    <pthread.h>
 #include    <sys/ioctl.h>
+#include    <sys/inotify.h>
+#include    <time.h>
+#include    <linux/input.h>
 #include    <linux/joystick.h>
 #include    <glib.h>
 
 #include    "ico_ictl-local.h"
+#include    "ico_ictl-latency.h"
+
+/* dispatch table size                                                              */
+#define ICO_ICTL_JS_TYPE_MAX    (JS_EVENT_AXIS+1)   /* js_event.type(1:button,2:axis)   */
+#define ICO_ICTL_JS_NUMBER_MAX  (256)               /* js_event.number is 8 bits        */
+
+/* max number of devices in a process                                              */
+#define ICO_ICTL_JS_DEVICE_MAX  (8)
+
+/* hotplug                                                                          */
+#define ICO_ICTL_JS_HOTPLUG_DIR "/dev/input"        /* directory of device file         */
+
+/* event read buffer size                                                           */
+#define ICO_ICTL_JS_READ_NUM    (8)                 /* events per read(normal mode)     */
+#define ICO_ICTL_JS_RING_NUM    (256)               /* batch buffer(drain mode)         */
+#define ICO_ICTL_JS_FRAME_NUM   (64)                /* evdev events between SYN_REPORT  */
+
+/* evdev interface                                                                  */
+#define ICO_ICTL_JS_KEY_NUM     (KEY_CNT - BTN_MISC)/* keys mapped to js button         */
+#define ICO_ICTL_JS_AXIS_VALUE  (32767)             /* js axis value range(+/-)         */
+#define ICO_ICTL_JS_BITS(n)     (((n) + (8 * sizeof(long)) - 1) / (8 * sizeof(long)))
 
 /* type definition                                                                  */
-typedef struct  _Ico_ICtl_JS    {
-    int                     fd;                 /* device file fd                   */
-    char                    device[32];         /* device name                      */
-    char                    ictl[32];           /* input controller name            */
-    int                     type;               /* device type                      */
-    int                     hostid;             /* host Id(currently unused)        */
-}   Ico_ICtl_JS;
+typedef struct  _Ico_ICtl_JS_Stat   {
+    unsigned int            batch;              /* number of read batch(wakeup)     */
+    unsigned int            read;               /* number of read system call       */
+    unsigned int            event;              /* number of read event             */
+    unsigned int            savewake;           /* saved wakeup by drain mode       */
+    int                     savecall;           /* saved system call by drain mode  */
+    unsigned int            suppress;           /* suppressed raw axis events       */
+    unsigned int            reconnect;          /* number of reconnect(hotplug)     */
+    unsigned int            downtime;           /* total downtime(ms) of reconnect  */
+}   Ico_ICtl_JS_Stat;
+
+typedef struct  _Ico_ICtl_JS_Event  {
+    unsigned long long      time;               /* event time(CLOCK_MONOTONIC, us)  */
+    int                     value;              /* value(js_event.value)            */
+    unsigned char           type;               /* type(js_event.type)              */
+    unsigned char           number;             /* number(js_event.number)          */
+}   Ico_ICtl_JS_Event;
+
+typedef struct  _Ico_ICtl_JS_Evdev  {
+    short                   keymap[ICO_ICTL_JS_KEY_NUM];/* key code to button number*/
+    short                   absmap[ABS_CNT];    /* abs code to axis number          */
+    int                     abscenter[ABS_CNT]; /* center value of axis             */
+    int                     absrange[ABS_CNT];  /* half range of axis               */
+    int                     nframe;             /* events of current frame          */
+    int                     dropped;            /* SYN_DROPPED, skip to SYN_REPORT  */
+    Ico_ICtl_JS_Event       frame[ICO_ICTL_JS_FRAME_NUM];/* current frame           */
+}   Ico_ICtl_JS_Evdev;
 
 typedef struct  _Ico_Ictl_Code  {
     unsigned short          code;               /* code value                       */
@@ -46,29 +90,61 @@ typedef struct  _Ico_ICtl_JS_Input  {
     int                     number;             /* input event number               */
     Ico_Ictl_Code           code[20];           /* key code                         */
     int                     last;               /* last input code                  */
+    int                     deadzone;           /* axis: deadzone around center     */
+    int                     threshold;          /* axis: press threshold            */
+    int                     hysteresis;         /* axis: release hysteresis         */
+    int                     dir;                /* state(axis:-1,0,1 button:0,1)    */
+    unsigned int            suppress;           /* number of suppressed raw events  */
 }   Ico_ICtl_JS_Input;
 
+typedef struct  _Ico_ICtl_JS    {
+    int                     fd;                 /* device file fd                   */
+    char                    device[32];         /* device name                      */
+    char                    ictl[32];           /* input controller name            */
+    int                     type;               /* device type                      */
+    int                     hostid;             /* host Id(currently unused)        */
+    int                     evdev;              /* device interface(0:js, 1:evdev)  */
+    char                    open[64];           /* device name to open              */
+    struct timespec         lost;               /* disconnected time                */
+    int                     nInput;             /* number of input switch           */
+    Ico_ICtl_JS_Input       *input;             /* input switch table               */
+                                                /* dispatch table(type,number)      */
+    Ico_ICtl_JS_Input       *map[ICO_ICTL_JS_TYPE_MAX][ICO_ICTL_JS_NUMBER_MAX];
+    Ico_ICtl_JS_Stat        stat;               /* statistics of event read         */
+    Ico_ICtl_JS_Evdev       *ev;                /* evdev interface state            */
+}   Ico_ICtl_JS;
+
 /* prototype of static function                                                     */
+static void ico_ictl_js_configure(Ico_ICtl_JS *js);
+static int ico_ictl_js_held(Ico_ICtl_JS *js, int fd);
+static void ico_ictl_latency_dump(void);
 static void PrintUsage(const char *pName);
 
 /* table/variable                                                                   */
-int                 mPseudo = 0;                /* pseudo input device for test     */
 int                 mDebug = 0;                 /* debug mode                       */
 int                 mEventLog = 0;              /* event input log                  */
+int                 mDrain = 0;                 /* drain mode(read until EAGAIN)    */
+int                 mEvdev = 0;                 /* use evdev interface for all device*/
+int                 mMask = 1;                  /* filter unused codes in kernel    */
+struct timespec     gStartTime;                 /* start time of main loop          */
 struct timeval      lastEvent = { 0, 0 };       /* last input event time            */
 int                 gRunning = 1;               /* run state(1:run, 0:finish)       */
+int                 gDumpLatency = 0;           /* dump latency(SIGUSR1)            */
+Ico_ICtl_Latency    gLatRead;                   /* event time to read               */
+Ico_ICtl_Latency    gLatFlush;                  /* event time to flush              */
 
 /* Input Contorller Table           */
 Ico_ICtl_Mng        gIco_ICtrl_Mng = { 0 };
-Ico_ICtl_JS         gIco_ICtrl_JS = { 0 };
-int                 nIco_ICtrl_JS_Input = 0;
-Ico_ICtl_JS_Input   *gIco_ICtrl_JS_Input = NULL;
+Ico_ICtl_JS         gIco_ICtrl_JS[ICO_ICTL_JS_DEVICE_MAX];
+int                 nIco_ICtrl_JS = 0;
+int                 gHotplugFd = -1;            /* inotify descriptor for hotplug   */
 
 /* static functions                 */
 /*--------------------------------------------------------------------------*/
 /**
  * @brief   ico_ictl_find_input_by_name: find Input Table by input switch name
  *
+ * @param[in]   js          device
  * @param[in]   name        input switch name
  * @return  result
  * @retval  !=NULL      success(Input Table address)
@@ -76,14 +152,14 @@ Ico_ICtl_JS_Input   *gIco_ICtrl_JS_Input = NULL;
  */
 /*--------------------------------------------------------------------------*/
 static Ico_ICtl_JS_Input *
-ico_ictl_find_input_by_name(const char *name)
+ico_ictl_find_input_by_name(Ico_ICtl_JS *js, const char *name)
 {
     Ico_ICtl_JS_Input   *iMng = NULL;
     int                  ii;
 
-    for (ii = 0; ii < nIco_ICtrl_JS_Input; ii++)    {
-        if (strncasecmp(name, gIco_ICtrl_JS_Input[ii].name, 16) == 0) {
-            iMng = &gIco_ICtrl_JS_Input[ii];
+    for (ii = 0; ii < js->nInput; ii++)    {
+        if (strncasecmp(name, js->input[ii].name, 16) == 0) {
+            iMng = &js->input[ii];
             break;
         }
     }
@@ -93,7 +169,9 @@ ico_ictl_find_input_by_name(const char *name)
 /*--------------------------------------------------------------------------*/
 /**
  * @brief   ico_ictl_find_input_by_param: find Input Table by input switch type and number
+ *          (direct index of dispatch table)
  *
+ * @param[in]   js          device
  * @param[in]   type        input event type (of Linux Input subsystem)
  * @param[in]   number      input event number (of Linux Input subsystem)
  * @return  result
@@ -102,19 +180,48 @@ ico_ictl_find_input_by_name(const char *name)
  */
 /*--------------------------------------------------------------------------*/
 static Ico_ICtl_JS_Input *
-ico_ictl_find_input_by_param(int type, int number)
+ico_ictl_find_input_by_param(Ico_ICtl_JS *js, int type, int number)
 {
-    Ico_ICtl_JS_Input   *iMng = NULL;
-    int                  ii;
+    if ((type <= 0) || (type >= ICO_ICTL_JS_TYPE_MAX) ||
+        (number < 0) || (number >= ICO_ICTL_JS_NUMBER_MAX)) {
+        /* initial state event(JS_EVENT_INIT) or out of range   */
+        return NULL;
+    }
+    return js->map[type][number];
+}
 
-    for (ii = 0; ii < nIco_ICtrl_JS_Input; ii++)    {
-        if ((gIco_ICtrl_JS_Input[ii].type == type)
-            && (gIco_ICtrl_JS_Input[ii].number == number))  {
-            iMng = &gIco_ICtrl_JS_Input[ii];
-            break;
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief   ico_ictl_make_dispatch: make dispatch table of input switch
+ *
+ * @param[in]   js          device
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+static void
+ico_ictl_make_dispatch(Ico_ICtl_JS *js)
+{
+    Ico_ICtl_JS_Input   *iMng;
+    int                 ii;
+
+    memset(js->map, 0, sizeof(js->map));
+
+    for (ii = 0; ii < js->nInput; ii++)    {
+        iMng = &js->input[ii];
+        if ((iMng->type <= 0) || (iMng->type >= ICO_ICTL_JS_TYPE_MAX) ||
+            (iMng->number < 0) || (iMng->number >= ICO_ICTL_JS_NUMBER_MAX)) {
+            ERROR_PRINT("ico_ictl_make_dispatch: switch(%s) illegal event(%d;%d)",
+                        iMng->name, iMng->type, iMng->number);
+            continue;
+        }
+        if (js->map[iMng->type][iMng->number] != NULL)  {
+            /* multiple define, first switch is used    */
+            ERROR_PRINT("ico_ictl_make_dispatch: switch(%s) event(%d;%d) re-define",
+                        iMng->name, iMng->type, iMng->number);
+            continue;
         }
+        js->map[iMng->type][iMng->number] = iMng;
     }
-    return iMng;
 }
 
 /*--------------------------------------------------------------------------*/
@@ -143,6 +250,31 @@ conf_getUint(const char *str)
     return key;
 }
 
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief   conf_getInt: get integer value of configuration key
+ *
+ * @param[in]   keyfile     configuration file
+ * @param[in]   group       configuration key group name
+ * @param[in]   key         configuration key name
+ * @param[in]   defval      default value(key not exist)
+ * @return  configuration value
+ */
+/*--------------------------------------------------------------------------*/
+static int
+conf_getInt(GKeyFile *keyfile, const char *group, const char *key, int defval)
+{
+    GError  *error = NULL;
+    int     val;
+
+    val = g_key_file_get_integer(keyfile, group, key, &error);
+    if (error)  {
+        g_error_free(error);
+        val = defval;
+    }
+    return val;
+}
+
 /*--------------------------------------------------------------------------*/
 /**
  * @brief   conf_countNumericalKey: get configuration list
@@ -193,22 +325,19 @@ conf_appendStr(const char *str1, const char *str2)
 
 /*--------------------------------------------------------------------------*/
 /**
- * @brief   ico_ictl_read_conf: read configuration file
+ * @brief   ico_ictl_read_device: read configuration of a device
  *
- * @param[in]   file        configuration file path name
- * @return  result
- * @retval  ICO_ICTL_OK     sccess
- * @retval  ICO_ICTL_ERR    failed
+ * @param[in]   keyfile     configuration file
+ * @param[in]   dgroup      device section name
+ * @param[in]   igroup      input switch section name
+ * @param[out]  js          device
+ * @return      nothing
  */
 /*--------------------------------------------------------------------------*/
-static int
-ico_ictl_read_conf(const char *file)
+static void
+ico_ictl_read_device(GKeyFile *keyfile, const char *dgroup, const char *igroup,
+                     Ico_ICtl_JS *js)
 {
-    DEBUG_PRINT("ico_ictl_read_conf: Enter(file=%s)", file);
-
-    GKeyFile            *keyfile;
-    GKeyFileFlags       flags;
-    GString             *filepath;
     GList               *idlist;
     GError              *error = NULL;
     Ico_ICtl_JS_Input   *iMng;
@@ -216,47 +345,40 @@ ico_ictl_read_conf(const char *file)
     gsize               length;
     int                 ii, jj;
 
-    keyfile = g_key_file_new();
-    flags = G_KEY_FILE_KEEP_COMMENTS | G_KEY_FILE_KEEP_TRANSLATIONS;
-
-    filepath = g_string_new(file);
-
-    if (! g_key_file_load_from_file(keyfile, filepath->str, flags, &error)) {
-        ERROR_PRINT("ico_ictl_read_conf: Leave(can not open conf file)");
-        g_string_free(filepath, TRUE);
-        return ICO_ICTL_ERR;
-    }
-    g_string_free(filepath, TRUE);
-
-    /* count number of key in [device] section   */
-    memset((char *)&gIco_ICtrl_JS, 0, sizeof(gIco_ICtrl_JS));
-    name = g_key_file_get_string(keyfile, "device", "name", &error);
+    /* [device] section                          */
+    memset((char *)js, 0, sizeof(Ico_ICtl_JS));
+    js->fd = -1;
+    name = g_key_file_get_string(keyfile, dgroup, "name", &error);
     if (name)   {
-        strncpy(gIco_ICtrl_JS.device, name, sizeof(gIco_ICtrl_JS.device)-1);
+        strncpy(js->device, name, sizeof(js->device)-1);
     }
-    name = g_key_file_get_string(keyfile, "device", "ictl", &error);
+    name = g_key_file_get_string(keyfile, dgroup, "ictl", &error);
     if (name)   {
-        strncpy(gIco_ICtrl_JS.ictl, name, sizeof(gIco_ICtrl_JS.ictl)-1);
+        strncpy(js->ictl, name, sizeof(js->ictl)-1);
     }
-    gIco_ICtrl_JS.type = g_key_file_get_integer(keyfile, "device", "type", &error);
-    gIco_ICtrl_JS.hostid = g_key_file_get_integer(keyfile, "device", "ecu", &error);
+    name = g_key_file_get_string(keyfile, dgroup, "interface", &error);
+    if ((name != NULL) && (strcasecmp(name, "evdev") == 0)) {
+        js->evdev = 1;
+    }
+    js->type = g_key_file_get_integer(keyfile, dgroup, "type", &error);
+    js->hostid = g_key_file_get_integer(keyfile, dgroup, "ecu", &error);
 
     /* count number of key in [input] section   */
-    idlist = conf_countNumericalKey(keyfile, "input");
+    idlist = conf_countNumericalKey(keyfile, igroup);
     length = g_list_length(idlist);
     if (length <= 0)    {
         length = 1;
     }
-    nIco_ICtrl_JS_Input = 0;
-    gIco_ICtrl_JS_Input = (Ico_ICtl_JS_Input *)malloc(sizeof(Ico_ICtl_JS_Input) * length);
-    if (! gIco_ICtrl_JS_Input)  {
+    js->nInput = 0;
+    js->input = (Ico_ICtl_JS_Input *)malloc(sizeof(Ico_ICtl_JS_Input) * length);
+    if (! js->input)  {
         ERROR_PRINT("joystick_gtforce: No Memory");
         exit(1);
     }
-    memset((char *)gIco_ICtrl_JS_Input, 0, sizeof(Ico_ICtl_JS_Input) * length);
+    memset((char *)js->input, 0, sizeof(Ico_ICtl_JS_Input) * length);
 
     for (ii = 0; ii < (int)length; ii++) {
-        const char  *g = "input";
+        const char  *g = igroup;
         char        *key = (char *)g_list_nth_data(idlist, ii);
         gsize       listsize;
         gint        *attr;
@@ -265,13 +387,13 @@ ico_ictl_read_conf(const char *file)
         name = g_key_file_get_string(keyfile, g, key, &error);
         if (name == NULL)   continue;
 
-        iMng = ico_ictl_find_input_by_name(name);
+        iMng = ico_ictl_find_input_by_name(js, name);
         if (iMng != NULL)   {
             /* multiple define  */
             ERROR_PRINT("ico_ictl_read_conf: switch name(%s) re-define", name);
             continue;
         }
-        iMng = &gIco_ICtrl_JS_Input[nIco_ICtrl_JS_Input];
+        iMng = &js->input[js->nInput];
 
         iMng->input = conf_getUint(key);
         strncpy(iMng->name, name, sizeof(iMng->name)-1);
@@ -308,22 +430,298 @@ ico_ictl_read_conf(const char *file)
         }
         if (code)   g_strfreev(code);
 
-        nIco_ICtrl_JS_Input ++;
+        /* deadzone, threshold and hysteresis of axis   */
+        iMng->deadzone = conf_getInt(keyfile, g, conf_appendStr(key, ".deadzone"), 0);
+        iMng->threshold = conf_getInt(keyfile, g, conf_appendStr(key, ".threshold"), 1);
+        iMng->hysteresis = conf_getInt(keyfile, g, conf_appendStr(key, ".hysteresis"), 0);
+        if (iMng->deadzone < 0) iMng->deadzone = 0;
+        if (iMng->threshold <= iMng->deadzone)  {
+            iMng->threshold = iMng->deadzone + 1;
+        }
+        if (iMng->hysteresis < 0)   iMng->hysteresis = 0;
+        if (iMng->hysteresis >= iMng->threshold)    {
+            iMng->hysteresis = iMng->threshold - 1;
+        }
+
+        js->nInput ++;
 
-        DEBUG_PRINT("%s input:%d(type=%d,number=%d,code=%d[%s],%d[%s])",
-                    iMng->name, iMng->input, iMng->type, iMng->number,
+        DEBUG_PRINT("%s %s input:%d(type=%d,number=%d,code=%d[%s],%d[%s],"
+                    "deadzone=%d,threshold=%d,hysteresis=%d)",
+                    js->device, iMng->name, iMng->input, iMng->type, iMng->number,
                     iMng->code[0].code, iMng->code[0].name,
-                    iMng->code[1].code, iMng->code[1].name);
+                    iMng->code[1].code, iMng->code[1].name,
+                    iMng->deadzone, iMng->threshold, iMng->hysteresis);
+    }
+
+    /* make dispatch table for event read   */
+    ico_ictl_make_dispatch(js);
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief   ico_ictl_read_conf: read configuration file
+ *          first device is [device] and [input] section, and following
+ *          devices are [device.N] and [input.N] section(N=1,2,...)
+ *
+ * @param[in]   file        configuration file path name
+ * @return  result
+ * @retval  ICO_ICTL_OK     sccess
+ * @retval  ICO_ICTL_ERR    failed
+ */
+/*--------------------------------------------------------------------------*/
+static int
+ico_ictl_read_conf(const char *file)
+{
+    DEBUG_PRINT("ico_ictl_read_conf: Enter(file=%s)", file);
+
+    GKeyFile            *keyfile;
+    GKeyFileFlags       flags;
+    GString             *filepath;
+    GError              *error = NULL;
+    char                dgroup[32];
+    char                igroup[32];
+    int                 ii;
+
+    keyfile = g_key_file_new();
+    flags = G_KEY_FILE_KEEP_COMMENTS | G_KEY_FILE_KEEP_TRANSLATIONS;
+
+    filepath = g_string_new(file);
+
+    if (! g_key_file_load_from_file(keyfile, filepath->str, flags, &error)) {
+        ERROR_PRINT("ico_ictl_read_conf: Leave(can not open conf file)");
+        g_string_free(filepath, TRUE);
+        return ICO_ICTL_ERR;
+    }
+    g_string_free(filepath, TRUE);
+
+    nIco_ICtrl_JS = 0;
+    for (ii = 0; ii < ICO_ICTL_JS_DEVICE_MAX; ii++) {
+        if (ii == 0)    {
+            strcpy(dgroup, "device");
+            strcpy(igroup, "input");
+        }
+        else    {
+            snprintf(dgroup, sizeof(dgroup), "device.%d", ii);
+            snprintf(igroup, sizeof(igroup), "input.%d", ii);
+            if (! g_key_file_has_group(keyfile, dgroup))    break;
+        }
+        ico_ictl_read_device(keyfile, dgroup, igroup, &gIco_ICtrl_JS[nIco_ICtrl_JS]);
+        nIco_ICtrl_JS ++;
+    }
+    g_key_file_free(keyfile);
+
+    DEBUG_PRINT("ico_ictl_read_conf: Leave(%d devices)", nIco_ICtrl_JS);
+
+    return ICO_ICTL_OK;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief   ico_ictl_evdev_setup: make key and axis map of evdev interface,
+ *          numbered in the same order as joydev, so js event number in the
+ *          configuration file is used for both interfaces
+ *
+ * @param[in]   js          device
+ * @param[in]   fd          event device file descriptor
+ * @return  result
+ * @retval  ICO_ICTL_OK     sccess
+ * @retval  ICO_ICTL_ERR    failed
+ */
+/*--------------------------------------------------------------------------*/
+static int
+ico_ictl_evdev_setup(Ico_ICtl_JS *js, int fd)
+{
+    Ico_ICtl_JS_Evdev   *ev;
+    unsigned long       keybit[ICO_ICTL_JS_BITS(KEY_CNT)];
+    unsigned long       absbit[ICO_ICTL_JS_BITS(ABS_CNT)];
+    struct input_absinfo absinfo;
+    int                 nkey = 0;
+    int                 naxis = 0;
+    int                 ii;
+
+#define ICO_ICTL_JS_TESTBIT(bit, array) \
+    ((array[(bit) / (8 * sizeof(long))] >> ((bit) % (8 * sizeof(long)))) & 1)
+
+    if (js->ev == NULL) {
+        js->ev = (Ico_ICtl_JS_Evdev *)malloc(sizeof(Ico_ICtl_JS_Evdev));
+        if (js->ev == NULL) {
+            ERROR_PRINT("ico_ictl_evdev_setup: No Memory");
+            return ICO_ICTL_ERR;
+        }
+    }
+    ev = js->ev;
+    memset(ev, 0, sizeof(Ico_ICtl_JS_Evdev));
+    memset(keybit, 0, sizeof(keybit));
+    memset(absbit, 0, sizeof(absbit));
+    if ((ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(keybit)), keybit) < 0) ||
+        (ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(absbit)), absbit) < 0))  {
+        ERROR_PRINT("ico_ictl_evdev_setup: can not get event bits[%d]", errno);
+        return ICO_ICTL_ERR;
+    }
+
+    /* event time in CLOCK_MONOTONIC for latency measurement    */
+    ii = CLOCK_MONOTONIC;
+    if (ioctl(fd, EVIOCSCLOCKID, &ii) < 0)  {
+        DEBUG_PRINT("ico_ictl_evdev_setup: EVIOCSCLOCKID not supported[%d]", errno);
+    }
+
+    /* joystick buttons first, and then other buttons(same as joydev)   */
+    for (ii = 0; ii < ICO_ICTL_JS_KEY_NUM; ii++)    {
+        ev->keymap[ii] = -1;
+    }
+    for (ii = BTN_JOYSTICK; ii < KEY_CNT; ii++) {
+        if ((ICO_ICTL_JS_TESTBIT(ii, keybit)) && (nkey < ICO_ICTL_JS_NUMBER_MAX))  {
+            ev->keymap[ii - BTN_MISC] = nkey++;
+        }
+    }
+    for (ii = BTN_MISC; ii < BTN_JOYSTICK; ii++)    {
+        if ((ICO_ICTL_JS_TESTBIT(ii, keybit)) && (nkey < ICO_ICTL_JS_NUMBER_MAX))  {
+            ev->keymap[ii - BTN_MISC] = nkey++;
+        }
     }
-    DEBUG_PRINT("ico_ictl_read_conf: Leave");
 
+    /* axes in order of code, value is scaled to js range   */
+    for (ii = 0; ii < ABS_CNT; ii++)    {
+        ev->absmap[ii] = -1;
+        if (! ICO_ICTL_JS_TESTBIT(ii, absbit))  continue;
+        if (ioctl(fd, EVIOCGABS(ii), &absinfo) < 0) continue;
+        ev->absmap[ii] = naxis++;
+        ev->abscenter[ii] = (absinfo.minimum + absinfo.maximum) / 2;
+        ev->absrange[ii] = (absinfo.maximum - absinfo.minimum) / 2;
+        if (ev->absrange[ii] <= 0)  {
+            ev->absrange[ii] = 1;
+        }
+    }
+#undef  ICO_ICTL_JS_TESTBIT
+
+    DEBUG_PRINT("ico_ictl_evdev_setup: %s buttons=%d axes=%d", js->device, nkey, naxis);
     return ICO_ICTL_OK;
 }
 
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief   ico_ictl_js_used: check if event(type,number) is used by input switch
+ *
+ * @param[in]   js          device
+ * @param[in]   type        js event type
+ * @param[in]   number      js event number
+ * @return  result
+ * @retval  1               used
+ * @retval  0               not used
+ */
+/*--------------------------------------------------------------------------*/
+static int
+ico_ictl_js_used(Ico_ICtl_JS *js, int type, int number)
+{
+    if ((number < 0) || (number >= ICO_ICTL_JS_NUMBER_MAX)) {
+        return 0;
+    }
+    return (js->map[type][number] != NULL) ? 1 : 0;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief   ico_ictl_evdev_mask: set kernel event mask(EVIOCSMASK), so the
+ *          device wakes up the process only for codes of input switch
+ *
+ * @param[in]   js          device
+ * @param[in]   fd          event device file descriptor
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+static void
+ico_ictl_evdev_mask(Ico_ICtl_JS *js, int fd)
+{
+#ifdef  EVIOCSMASK
+    Ico_ICtl_JS_Evdev   *ev = js->ev;
+    unsigned char       keymask[KEY_CNT / 8];
+    unsigned char       absmask[ABS_CNT / 8];
+    unsigned char       mscmask[MSC_CNT / 8 + 1];
+    struct input_mask   mask;
+    int                 nkey = 0;
+    int                 naxis = 0;
+    int                 ii;
+
+    memset(keymask, 0, sizeof(keymask));
+    memset(absmask, 0, sizeof(absmask));
+    memset(mscmask, 0, sizeof(mscmask));
+    for (ii = BTN_MISC; ii < KEY_CNT; ii++) {
+        if (ico_ictl_js_used(js, JS_EVENT_BUTTON, ev->keymap[ii - BTN_MISC]))   {
+            keymask[ii / 8] |= 1 << (ii % 8);
+            nkey ++;
+        }
+    }
+    for (ii = 0; ii < ABS_CNT; ii++)    {
+        if (ico_ictl_js_used(js, JS_EVENT_AXIS, ev->absmap[ii]))    {
+            absmask[ii / 8] |= 1 << (ii % 8);
+            naxis ++;
+        }
+    }
+
+    mask.type = EV_KEY;
+    mask.codes_size = sizeof(keymask);
+    mask.codes_ptr = (unsigned long)keymask;
+    if (ioctl(fd, EVIOCSMASK, &mask) < 0)   {
+        /* old kernel, all events are read and dropped by dispatch table    */
+        DEBUG_PRINT("ico_ictl_evdev_mask: EVIOCSMASK not supported[%d]", errno);
+        return;
+    }
+    mask.type = EV_ABS;
+    mask.codes_size = sizeof(absmask);
+    mask.codes_ptr = (unsigned long)absmask;
+    ioctl(fd, EVIOCSMASK, &mask);
+    /* miscellaneous(MSC_SCAN etc.) is not used     */
+    mask.type = EV_MSC;
+    mask.codes_size = sizeof(mscmask);
+    mask.codes_ptr = (unsigned long)mscmask;
+    ioctl(fd, EVIOCSMASK, &mask);
+
+    DEBUG_PRINT("ico_ictl_evdev_mask: %s subscribe buttons=%d axes=%d",
+                js->device, nkey, naxis);
+#else  /*EVIOCSMASK*/
+    DEBUG_PRINT("ico_ictl_evdev_mask: EVIOCSMASK not defined");
+#endif /*EVIOCSMASK*/
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief   ico_ictl_js_held: check that a device file is opened by other
+ *          device(identical devices have the same name)
+ *
+ * @param[in]   js              device to open
+ * @param[in]   fd              opened device file
+ * @return  result
+ * @retval  1               same node as other device
+ * @retval  0               not opened by other device
+ */
+/*--------------------------------------------------------------------------*/
+static int
+ico_ictl_js_held(Ico_ICtl_JS *js, int fd)
+{
+    struct stat st;
+    struct stat other;
+    int         ii;
+
+    if (fstat(fd, &st) < 0) {
+        return 0;
+    }
+    for (ii = 0; ii < nIco_ICtrl_JS; ii++)  {
+        if ((&gIco_ICtrl_JS[ii] == js) || (gIco_ICtrl_JS[ii].fd < 0))    continue;
+        if (fstat(gIco_ICtrl_JS[ii].fd, &other) < 0)    continue;
+        if (S_ISCHR(st.st_mode) ? (other.st_rdev == st.st_rdev) :
+            ((other.st_dev == st.st_dev) && (other.st_ino == st.st_ino)))    {
+            /* device node(or pseudo device file) */
+            return 1;
+        }
+    }
+    return 0;
+}
+
 /*--------------------------------------------------------------------------*/
 /**
  * @brief   ico_ictl_js_open: open input jyostick input device
  *
+ * @param[in]   js              device
  * @param[in]   ictlDevName     device name
  * @return  result
  * @retval  >= 0            sccess(device file descriptor)
@@ -331,7 +729,7 @@ ico_ictl_read_conf(const char *file)
  */
 /*--------------------------------------------------------------------------*/
 static int
-ico_ictl_js_open(const char *ictlDevName)
+ico_ictl_js_open(Ico_ICtl_JS *js, const char *ictlDevName)
 {
     DEBUG_PRINT("ico_ictl_js_open: Enter(device=%s)", ictlDevName)
 
@@ -345,16 +743,12 @@ ico_ictl_js_open(const char *ictlDevName)
         return ICO_ICTL_ERR;
     }
 
-    char *pdev = getenv(ICO_ICTL_INPUT_DEV);
-    if ((pdev != NULL) && (*pdev != 0)) {
-        DEBUG_PRINT("ico_ictl_js_open: Pseudo input device(%s)", pdev);
-        mPseudo = 1;
-    }
-    else    {
-        pdev = (char *)ictlDevName;
+    char *pdev = (char *)ictlDevName;
+    if (js->evdev)  {
+        DEBUG_PRINT("ico_ictl_js_open: evdev input device(%s)", pdev);
     }
     for (ii = 0; ii < 16; ii++) {
-        if (mPseudo)    {
+        if (js->evdev)  {
             snprintf(devFile, 64, "/dev/input/event%d", ii);
         }
         else    {
@@ -364,7 +758,7 @@ ico_ictl_js_open(const char *ictlDevName)
         if (fd < 0)     continue;
 
         memset(devName, 0, sizeof(devName));
-        if (mPseudo)    {
+        if (js->evdev)  {
             ioctl(fd, EVIOCGNAME(sizeof(devName)), devName);
         }
         else    {
@@ -379,8 +773,9 @@ ico_ictl_js_open(const char *ictlDevName)
         devName[kk] = 0;
         DEBUG_PRINT("ico_ictl_js_open: %d.%s", ii+1, devName);
 
-        if (strncasecmp(devName, pdev, sizeof(devName)) == 0)   break;
-        /* not match, close */
+        if ((strncasecmp(devName, pdev, sizeof(devName)) == 0) &&
+            (! ico_ictl_js_held(js, fd)))   break;
+        /* not match(or opened by other device of same name), close */
         close(fd);
         fd = -1;
     }
@@ -389,72 +784,212 @@ ico_ictl_js_open(const char *ictlDevName)
         ERROR_PRINT("ico_ictl_js_open: Leave(not find device file)");
         return ICO_ICTL_ERR;
     }
+    if ((js->evdev) && (ico_ictl_evdev_setup(js, fd) != ICO_ICTL_OK))  {
+        close(fd);
+        ERROR_PRINT("ico_ictl_js_open: Leave(can not setup evdev)");
+        return ICO_ICTL_ERR;
+    }
+    if ((mMask) && (js->evdev))  {
+        /* js interface has no event mask, unused codes are dropped by dispatch table */
+        ico_ictl_evdev_mask(js, fd);
+    }
     DEBUG_PRINT("ico_ictl_js_open: Leave(found %s[%s] as %s)", pdev, devFile, ictlDevName);
     return fd;
 }
 
 /*--------------------------------------------------------------------------*/
 /**
- * @brief   ico_ictl_js_read: read input jyostick input device
+ * @brief   ico_ictl_evdev_frame: convert evdev events to joystick events,
+ *          events are held until SYN_REPORT and output as a frame
  *
- * @param[in]   fd          file descriptor
- * @return      nothing
+ * @param[in]   js          device
+ * @param[in]   raw         evdev events
+ * @param[in]   nraw        number of evdev events
+ * @param[out]  events      joystick events(nraw + ICO_ICTL_JS_FRAME_NUM)
+ * @return      number of joystick events
  */
 /*--------------------------------------------------------------------------*/
-static void
-ico_ictl_js_read(int fd)
+static int
+ico_ictl_evdev_frame(Ico_ICtl_JS *js, struct input_event *raw, int nraw,
+                     Ico_ICtl_JS_Event *events)
 {
-    DEBUG_PRINT("ico_ictl_js_read: Enter(fd=%d)", fd)
+    Ico_ICtl_JS_Evdev   *ev = js->ev;
+    Ico_ICtl_JS_Event   *jev;
+    int                 num = 0;
+    int                 number, value;
+    int                 ii;
+
+    for (ii = 0; ii < nraw; ii++)   {
+        switch (raw[ii].type)   {
+        case EV_SYN:
+            if (raw[ii].code == SYN_DROPPED)    {
+                /* kernel buffer overrun, discard until next SYN_REPORT */
+                ev->dropped = 1;
+                ev->nframe = 0;
+            }
+            else if (raw[ii].code == SYN_REPORT)    {
+                if (! ev->dropped)  {
+                    memcpy(&events[num], ev->frame,
+                           sizeof(Ico_ICtl_JS_Event) * ev->nframe);
+                    num += ev->nframe;
+                }
+                ev->dropped = 0;
+                ev->nframe = 0;
+            }
+            continue;
+        case EV_KEY:
+            if ((raw[ii].code < BTN_MISC) || (raw[ii].code >= KEY_CNT)) continue;
+            number = ev->keymap[raw[ii].code - BTN_MISC];
+            if ((number < 0) || (raw[ii].value == 2))   continue;   /* autorepeat */
+            value = raw[ii].value;
+            break;
+        case EV_ABS:
+            if (raw[ii].code >= ABS_CNT)    continue;
+            number = ev->absmap[raw[ii].code];
+            if (number < 0) continue;
+            value = ((long long)(raw[ii].value - ev->abscenter[raw[ii].code])
+                     * ICO_ICTL_JS_AXIS_VALUE) / ev->absrange[raw[ii].code];
+            if (value > ICO_ICTL_JS_AXIS_VALUE)         value = ICO_ICTL_JS_AXIS_VALUE;
+            else if (value < -ICO_ICTL_JS_AXIS_VALUE)   value = -ICO_ICTL_JS_AXIS_VALUE;
+            break;
+        default:
+            continue;
+        }
+        if ((ev->dropped) || (ev->nframe >= ICO_ICTL_JS_FRAME_NUM)) continue;
+
+        jev = &ev->frame[ev->nframe++];
+        jev->time = (unsigned long long)raw[ii].time.tv_sec * 1000000ULL +
+                    (unsigned long long)raw[ii].time.tv_usec;
+        jev->type = (raw[ii].type == EV_KEY) ? JS_EVENT_BUTTON : JS_EVENT_AXIS;
+        jev->number = number;
+        jev->value = value;
+    }
+    return num;
+}
 
-    struct js_event     events[8];
-    struct input_event  pevents[8];
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief   ico_ictl_js_fill: read events from input jyostick input device
+ *
+ * @param[in]   js          device
+ * @param[out]  events      read event buffer(num + ICO_ICTL_JS_FRAME_NUM)
+ * @param[in]   num         max number of events to read
+ * @param[out]  nraw        number of events read from device
+ * @return  result
+ * @retval  >= 0            success(number of joystick events)
+ * @retval  < 0             read error(errno is set)
+ */
+/*--------------------------------------------------------------------------*/
+static int
+ico_ictl_js_fill(Ico_ICtl_JS *js, Ico_ICtl_JS_Event *events, int num, int *nraw)
+{
+    static struct input_event   revents[ICO_ICTL_JS_RING_NUM];
+    static struct js_event      jevents[ICO_ICTL_JS_RING_NUM];
     int                 rSize;
-    int                 ii, jj;
-    int                 number, value, type, code, state;
-
-    if (mPseudo)    {
-        /* Pseudo event input for Debug */
-        rSize = read(fd, pevents, sizeof(pevents));
-        if (rSize > 0)  {
-            for (ii = 0; ii < rSize/((int)sizeof(struct input_event)); ii++)    {
-                events[ii].time = (pevents[ii].time.tv_sec % 1000) * 1000 +
-                                  pevents[ii].time.tv_usec / 1000;
-                events[ii].type = pevents[ii].type;
-                events[ii].number = pevents[ii].code;
-                events[ii].value = pevents[ii].value;
-                if ((events[ii].type == 2) && (events[ii].value == 9))  {
-                    events[ii].value = 0;
-                }
-                else if ((events[ii].type == 1) && (events[ii].number == 9))    {
-                    events[ii].number = 0;
-                }
-                DEBUG_PRINT("ico_ictl_js_read: pseude event.%d %d.%d.%d",
-                            ii, events[ii].type, events[ii].number, events[ii].value);
+    int                 ii;
+    unsigned long long  now;
+
+    *nraw = 0;
+    if (js->evdev)  {
+        rSize = read(js->fd, revents, sizeof(struct input_event) * num);
+        if (rSize <= 0) {
+            return rSize;
+        }
+        *nraw = rSize / (int)sizeof(struct input_event);
+        /* latency from kernel event time to read, per frame    */
+        now = ico_ictl_latency_now();
+        for (ii = 0; ii < *nraw; ii++)  {
+            if ((revents[ii].type == EV_SYN) && (revents[ii].code == SYN_REPORT))  {
+                ico_ictl_latency_add(&gLatRead,
+                        (unsigned long long)revents[ii].time.tv_sec * 1000000ULL +
+                        (unsigned long long)revents[ii].time.tv_usec, now);
             }
-            rSize = ii * sizeof(struct js_event);
         }
+        return ico_ictl_evdev_frame(js, revents, *nraw, events);
+    }
+    rSize = read(js->fd, jevents, sizeof(struct js_event) * num);
+    if (rSize <= 0) {
+        return rSize;
+    }
+    *nraw = rSize / (int)sizeof(struct js_event);
+    /* js_event.time is milli-sec of other clock(and wraps), use read time */
+    now = ico_ictl_latency_now();
+    for (ii = 0; ii < *nraw; ii++)  {
+        events[ii].time = now;
+        events[ii].type = jevents[ii].type;
+        events[ii].number = jevents[ii].number;
+        events[ii].value = jevents[ii].value;
+    }
+    return *nraw;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief   ico_ictl_js_axis: get direction of two codes input(axis)
+ *          value in the deadzone is center, a direction is pressed when
+ *          the value reaches the threshold, and released when the value
+ *          falls below (threshold - hysteresis)
+ *
+ * @param[in]   iMng        input switch
+ * @param[in]   value       axis value
+ * @return  direction
+ * @retval  -1              first code(minus side)
+ * @retval  0               center(no code)
+ * @retval  1               second code(plus side)
+ */
+/*--------------------------------------------------------------------------*/
+static int
+ico_ictl_js_axis(Ico_ICtl_JS_Input *iMng, int value)
+{
+    int     mag, sign;
+
+    if (value < 0)  {
+        mag = - value;
+        sign = -1;
     }
     else    {
-        rSize = read(fd, events, sizeof(events));
+        mag = value;
+        sign = 1;
     }
-    if (rSize < 0)  {
-        ii = errno;
-        if ((ii == EINTR) || (ii == EAGAIN))    {
-            return;
-        }
-        DEBUG_PRINT("ico_ictl_js_read: Leave(read error[%d])", ii)
-        exit(9);
+    if (mag <= iMng->deadzone)  {
+        return 0;
     }
-    for (ii = 0; ii < (rSize / (int)sizeof(struct js_event)); ii++) {
+    if (sign == iMng->dir)  {
+        /* same direction, keep until the value falls below hysteresis  */
+        return (mag >= (iMng->threshold - iMng->hysteresis)) ? sign : 0;
+    }
+    return (mag >= iMng->threshold) ? sign : 0;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief   ico_ictl_js_event: convert jyostick events and send to Input Manager
+ *
+ * @param[in]   js          device
+ * @param[in]   events      joystick events
+ * @param[in]   num         number of events
+ * @return      number of requests to Input Manager
+ */
+/*--------------------------------------------------------------------------*/
+static int
+ico_ictl_js_event(Ico_ICtl_JS *js, Ico_ICtl_JS_Event *events, int num)
+{
+    int                 ii;
+    int                 nsend = 0;
+    int                 number, value, type, code, state, dir;
+    uint32_t            time;
+
+    for (ii = 0; ii < num; ii++) {
         Ico_ICtl_JS_Input   *iMng = NULL;
 
         type = events[ii].type;
         number = events[ii].number;
         value = events[ii].value;
-        DEBUG_PRINT("ico_ictl_js_read: Read(type=%d, number=%d, value=%d",
+        time = (uint32_t)(events[ii].time / 1000);     /* ms for Input Manager */
+        DEBUG_PRINT("ico_ictl_js_event: Event(type=%d, number=%d, value=%d)",
                     type, number, value);
 
-        iMng = ico_ictl_find_input_by_param(type, number);
+        iMng = ico_ictl_find_input_by_param(js, type, number);
         if (iMng == NULL) {
             continue;
         }
@@ -487,50 +1022,328 @@ ico_ictl_js_read(int fd)
                 lastEvent.tv_sec = curtime.tv_sec;
                 lastEvent.tv_usec = curtime.tv_usec;
             }
-            for (jj = 0;
-                 jj < (int)(sizeof(gIco_ICtrl_JS_Input)/sizeof(Ico_ICtl_JS_Input)); jj++) {
-                if ((type == gIco_ICtrl_JS_Input[jj].type) &&
-                    (number == gIco_ICtrl_JS_Input[jj].number))  {
-                    break;
-                }
-            }
         }
 
         if (iMng->code[1].code != 0)    {
-            if (value < 0) {
-                code = iMng->code[0].code;
-                state = WL_KEYBOARD_KEY_STATE_PRESSED;
-                iMng->last = code;
+            /* two codes input(axis), send only crossing of threshold   */
+            dir = ico_ictl_js_axis(iMng, value);
+            if (dir == iMng->dir)   {
+                iMng->suppress ++;
+                js->stat.suppress ++;
+                continue;
             }
-            else if (value > 0) {
-                code = iMng->code[1].code;
-                state = WL_KEYBOARD_KEY_STATE_PRESSED;
-                iMng->last = code;
+            if (iMng->dir != 0) {
+                /* release previous direction   */
+                ico_input_mgr_device_input_event(gIco_ICtrl_Mng.Wayland_InputMgr,
+                                                 time, js->device,
+                                                 iMng->input, iMng->last,
+                                                 WL_KEYBOARD_KEY_STATE_RELEASED);
+                nsend ++;
             }
-            else {
-                if (iMng->last != iMng->code[0].code && iMng->last != iMng->code[1].code) {
-                    continue;
-                }
-                code = iMng->last;
-                state = WL_KEYBOARD_KEY_STATE_RELEASED;
+            iMng->dir = dir;
+            if (dir == 0)   {
                 iMng->last = -1;
+                continue;
             }
+            code = (dir < 0) ? iMng->code[0].code : iMng->code[1].code;
+            state = WL_KEYBOARD_KEY_STATE_PRESSED;
+            iMng->last = code;
         }
         else    {
             if (value == 0) {
                 code = iMng->code[0].code;
                 state = WL_KEYBOARD_KEY_STATE_RELEASED;
+                iMng->dir = 0;
             }
             else if (value == 1) {
                 code = iMng->code[0].code;
                 state = WL_KEYBOARD_KEY_STATE_PRESSED;
+                iMng->dir = 1;
             }
             else {
                 continue;
             }
         }
-        ico_input_mgr_device_input_event(gIco_ICtrl_Mng.Wayland_InputMgr, events[ii].time,
-                                         gIco_ICtrl_JS.device, iMng->input, code, state);
+        ico_input_mgr_device_input_event(gIco_ICtrl_Mng.Wayland_InputMgr, time,
+                                         js->device, iMng->input, code, state);
+        nsend ++;
+    }
+    return nsend;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief   ico_ictl_js_disconnect: close unplugged device and release
+ *          pressed codes of the device
+ *
+ * @param[in]   js          device
+ * @param[in]   err         errno of read
+ * @return      number of requests to Input Manager
+ */
+/*--------------------------------------------------------------------------*/
+static int
+ico_ictl_js_disconnect(Ico_ICtl_JS *js, int err)
+{
+    Ico_ICtl_JS_Input   *iMng;
+    int                 ii;
+    int                 nsend = 0;
+
+    if (gHotplugFd < 0) {
+        /* can not wait for reconnect   */
+        DEBUG_PRINT("ico_ictl_js_disconnect: Leave(read error[%d])", err)
+        exit(9);
+    }
+    INFO_PRINT("%s: device disconnected[%d], wait for reconnect", js->device, err);
+
+    /* close removes the descriptor from epoll  */
+    close(js->fd);
+    js->fd = -1;
+    clock_gettime(CLOCK_MONOTONIC, &js->lost);
+
+    for (ii = 0; ii < js->nInput; ii++) {
+        iMng = &js->input[ii];
+        if (iMng->dir == 0) continue;
+        ico_input_mgr_device_input_event(gIco_ICtrl_Mng.Wayland_InputMgr, 0, js->device,
+                                         iMng->input,
+                                         (iMng->code[1].code != 0) ? iMng->last
+                                                                   : iMng->code[0].code,
+                                         WL_KEYBOARD_KEY_STATE_RELEASED);
+        iMng->dir = 0;
+        iMng->last = -1;
+        nsend ++;
+    }
+    return nsend;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief   ico_ictl_hotplug_init: watch device directory for hotplug
+ *
+ * @param       nothing
+ * @return  result
+ * @retval  >= 0            sccess(inotify descriptor)
+ * @retval  ICO_ICTL_ERR    failed
+ */
+/*--------------------------------------------------------------------------*/
+static int
+ico_ictl_hotplug_init(void)
+{
+    int     fd;
+
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        ERROR_PRINT("ico_ictl_hotplug_init: Leave(ERR), inotify init Error[%d]", errno);
+        return ICO_ICTL_ERR;
+    }
+    /* device file is created, and then udev changes its permission */
+    if (inotify_add_watch(fd, ICO_ICTL_JS_HOTPLUG_DIR, IN_CREATE | IN_ATTRIB) < 0)  {
+        ERROR_PRINT("ico_ictl_hotplug_init: Leave(ERR), inotify watch Error[%d]", errno);
+        close(fd);
+        return ICO_ICTL_ERR;
+    }
+    return fd;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief   ico_ictl_hotplug: reopen disconnected devices at hotplug event,
+ *          and re-send configuration to Multi Input Manager
+ *
+ * @param       nothing
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+static void
+ico_ictl_hotplug(void)
+{
+    char                buf[4096];
+    Ico_ICtl_JS         *js;
+    struct timespec     now;
+    int                 downtime;
+    int                 nconf = 0;
+    int                 ii;
+
+    /* discard inotify events, only need to know that the directory changed */
+    while (read(gHotplugFd, buf, sizeof(buf)) > 0)  ;
+
+    for (ii = 0; ii < nIco_ICtrl_JS; ii++)  {
+        js = &gIco_ICtrl_JS[ii];
+        if (js->fd >= 0)    continue;
+
+        js->fd = ico_ictl_js_open(js, js->open);
+        if (js->fd < 0) continue;
+        if (ico_ictl_add_fd(js->fd) != ICO_ICTL_OK) {
+            close(js->fd);
+            js->fd = -1;
+            continue;
+        }
+        ico_ictl_js_configure(js);
+        nconf ++;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        downtime = (now.tv_sec - js->lost.tv_sec) * 1000 +
+                   (now.tv_nsec - js->lost.tv_nsec) / 1000000;
+        js->stat.reconnect ++;
+        js->stat.downtime += downtime;
+        INFO_PRINT("%s: device reconnected(downtime=%dms)", js->device, downtime);
+    }
+    if (nconf > 0)  {
+        ico_ictl_wayland_flush();
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief   ico_ictl_js_read: read input jyostick input device
+ *          normal mode reads ICO_ICTL_JS_READ_NUM events per wakeup, drain
+ *          mode reads until the device has no event(EAGAIN) and converts
+ *          the whole batch at once
+ *
+ * @param[in]   js          device
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+static void
+ico_ictl_js_read(Ico_ICtl_JS *js)
+{
+    DEBUG_PRINT("ico_ictl_js_read: Enter(%s fd=%d)", js->device, js->fd)
+
+    static Ico_ICtl_JS_Event    events[ICO_ICTL_JS_RING_NUM + ICO_ICTL_JS_FRAME_NUM];
+    Ico_ICtl_JS_Stat    *stat = &js->stat;
+    int                 maxnum;
+    int                 nevent = 0;
+    int                 total = 0;
+    int                 nread = 0;
+    int                 rnum;
+    int                 room;
+    int                 nraw;
+    int                 nsend = 0;
+    int                 lost = 0;
+    int                 legacy;
+    unsigned long long  oldest = 0;
+
+    maxnum = mDrain ? ICO_ICTL_JS_RING_NUM : ICO_ICTL_JS_READ_NUM;
+
+    while (1)   {
+        room = maxnum - nevent;
+        rnum = ico_ictl_js_fill(js, &events[nevent], room, &nraw);
+        if (rnum < 0)   {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN)    {
+                break;
+            }
+            /* device unplugged or read error, wait for reconnect   */
+            lost = errno;
+            break;
+        }
+        nread ++;
+        if ((oldest == 0) && (rnum > 0))    {
+            oldest = events[nevent].time;
+        }
+        nevent += rnum;
+        total += nraw;
+        /* short read means that the device has no more event   */
+        if ((! mDrain) || (nraw < room))    {
+            break;
+        }
+        if (nevent >= maxnum)   {
+            /* batch buffer full, convert and continue to read  */
+            nsend += ico_ictl_js_event(js, events, nevent);
+            nevent = 0;
+        }
+    }
+    nsend += ico_ictl_js_event(js, events, nevent);
+    if (lost)   {
+        nsend += ico_ictl_js_disconnect(js, lost);
+    }
+
+    /* batch boundary, send all requests by one flush   */
+    if (nsend > 0)  {
+        ico_ictl_wayland_flush();
+        /* latency of the oldest event in the batch(worst of the batch) */
+        ico_ictl_latency_add(&gLatFlush, oldest, ico_ictl_latency_now());
+    }
+
+    stat->batch ++;
+    stat->read += nread;
+    stat->event += total;
+    if (mDrain) {
+        /* wakeup and system call(epoll_wait, read, flush) of normal mode   */
+        legacy = (total + ICO_ICTL_JS_READ_NUM - 1) / ICO_ICTL_JS_READ_NUM;
+        if (legacy <= 0)    legacy = 1;
+        stat->savewake += legacy - 1;
+        stat->savecall += (legacy * 3) - (nread + 2);
+        DEBUG_PRINT("ico_ictl_js_read: Leave(event=%d read=%d saved wakeup=%d syscall=%d)",
+                    total, nread, legacy - 1, (legacy * 3) - (nread + 2));
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief   ico_ictl_js_print_stat: print statistics of event read
+ *
+ * @param[in]   js          device
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+static void
+ico_ictl_js_print_stat(Ico_ICtl_JS *js)
+{
+    Ico_ICtl_JS_Stat    *stat = &js->stat;
+    struct timespec     now;
+    unsigned int        elapsed;
+    unsigned int        rate;
+    int                 ii;
+
+    /* wakeups per second(x100), compare with -n option for masking  */
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    elapsed = (now.tv_sec - gStartTime.tv_sec) * 1000 +
+              (now.tv_nsec - gStartTime.tv_nsec) / 1000000;
+    if (elapsed == 0)   elapsed = 1;
+    rate = (unsigned int)(((unsigned long long)stat->batch * 100000ULL) / elapsed);
+    INFO_PRINT("%s: wakeup/s=%u.%02u(%us) kernel filter=%s", js->device,
+               rate / 100, rate % 100, elapsed / 1000, ((mMask) && (js->evdev)) ? "on" : "off");
+    INFO_PRINT("%s: wakeup=%u read=%u event=%u saved(wakeup=%u syscall=%d)",
+               js->device, stat->batch, stat->read, stat->event,
+               stat->savewake, stat->savecall);
+    INFO_PRINT("%s: suppressed axis event=%u", js->device, stat->suppress);
+    INFO_PRINT("%s: reconnect=%u downtime=%ums", js->device,
+               stat->reconnect, stat->downtime);
+    for (ii = 0; ii < js->nInput; ii++)    {
+        if (js->input[ii].code[1].code == 0)    continue;
+        DEBUG_PRINT("ico_ictl_js_print_stat: %s suppressed=%u",
+                    js->input[ii].name, js->input[ii].suppress);
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief   ico_ictl_js_configure: send configuration of a device to
+ *          Multi Input Manager
+ *
+ * @param[in]   js          device
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+static void
+ico_ictl_js_configure(Ico_ICtl_JS *js)
+{
+    int                 ii, jj;
+
+    for (ii = 0; ii < js->nInput; ii++)    {
+        ico_input_mgr_device_configure_input(
+                gIco_ICtrl_Mng.Wayland_InputMgr, js->device, js->type,
+                js->input[ii].name, js->input[ii].input,
+                js->input[ii].code[0].name, js->input[ii].code[0].code);
+        for (jj = 1; jj < 20; jj++)     {
+            if (js->input[ii].code[jj].code == 0)   break;
+            ico_input_mgr_device_configure_code(
+                    gIco_ICtrl_Mng.Wayland_InputMgr, js->device,
+                    js->input[ii].input, js->input[ii].code[jj].name,
+                    js->input[ii].code[jj].code);
+        }
     }
 }
 
@@ -548,6 +1361,39 @@ signal_int(int signum)
     gRunning = 0;
 }
 
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief   signal_usr1: signal handler(dump latency at runtime)
+ *
+ * @param[in]   signum      signal number(unused)
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+static void
+signal_usr1(int signum)
+{
+    gDumpLatency = 1;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief   ico_ictl_latency_dump: print latency histograms(p50/p99/p99.9)
+ *
+ * @param       nothing
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+static void
+ico_ictl_latency_dump(void)
+{
+    char                buf[160];
+
+    ico_ictl_latency_format(&gLatRead, buf, sizeof(buf));
+    INFO_PRINT("%s", buf);
+    ico_ictl_latency_format(&gLatFlush, buf, sizeof(buf));
+    INFO_PRINT("%s", buf);
+}
+
 /*--------------------------------------------------------------------------*/
 /**
  * @brief   Device Input Controllers: For Joy Stick
@@ -562,11 +1408,14 @@ signal_int(int signum)
 int main(int argc, char *argv[])
 {
     struct epoll_event  ev_ret[16];
-    char                *ictlDevName = "DrivingForceGT";
-    int                 JSfd;
+    char                *ictlDevName = NULL;
+    char                *devName;
+    char                *pdev;
+    Ico_ICtl_JS         *js;
     int                 ii, jj;
     int                 ret;
     struct sigaction    sigint;
+    struct sigaction    sigusr1;
 
     /* get device name from parameter   */
     for (ii = 1; ii < argc; ii++) {
@@ -582,6 +1431,18 @@ int main(int argc, char *argv[])
             /* event input log  */
             mEventLog = 1;
         }
+        else if (strcasecmp( argv[ii], "-b") == 0) {
+            /* drain(batch read) mode   */
+            mDrain = 1;
+        }
+        else if (strcasecmp( argv[ii], "-e") == 0) {
+            /* evdev interface  */
+            mEvdev = 1;
+        }
+        else if (strcasecmp( argv[ii], "-n") == 0) {
+            /* no kernel filter(for comparison of wakeups)  */
+            mMask = 0;
+        }
         else {
             ictlDevName = argv[ii];
         }
@@ -595,55 +1456,101 @@ int main(int argc, char *argv[])
         }
     }
 
-    /* open joystick    */
-    JSfd = ico_ictl_js_open(ictlDevName);
-    if (JSfd < 0) {
-        ERROR_PRINT("main: Leave(Error device open)");
-        exit(1);
-    }
-    gIco_ICtrl_JS.fd = JSfd;
-
     /* read conf file   */
     char *confpath = getenv(ICO_ICTL_CONF_ENV);
     if (!confpath)  {
         confpath = ICO_ICTL_CONF_FILE;
     }
-    ico_ictl_read_conf(confpath);
+    if ((ico_ictl_read_conf(confpath) != ICO_ICTL_OK) || (nIco_ICtrl_JS <= 0))    {
+        ERROR_PRINT("main: Leave(Error conf file read)");
+        exit(1);
+    }
+
+    /* open joysticks   */
+    for (ii = 0; ii < nIco_ICtrl_JS; ii++)  {
+        js = &gIco_ICtrl_JS[ii];
+        devName = js->device;
+        if (mEvdev) {
+            js->evdev = 1;
+        }
+        if (ii == 0)    {
+            /* first device can be specified by parameter or pseudo device  */
+            if (ictlDevName != NULL)    {
+                devName = ictlDevName;
+            }
+            pdev = getenv(ICO_ICTL_INPUT_DEV);
+            if ((pdev != NULL) && (*pdev != 0)) {
+                js->evdev = 1;
+                devName = pdev;
+            }
+        }
+        if (snprintf(js->open, sizeof(js->open), "%s", devName) >= (int)sizeof(js->open))   {
+            /* longer than the name of device, never matches */
+            ERROR_PRINT("main: Leave(Error device name(%s) too long)", devName);
+            exit(1);
+        }
+        js->fd = ico_ictl_js_open(js, js->open);
+        if (js->fd < 0) {
+            ERROR_PRINT("main: Leave(Error device(%s) open)", devName);
+            exit(1);
+        }
+    }
 
     /* initialize wayland   */
     ico_ictl_wayland_init(NULL, NULL);
-    ico_ictl_add_fd(JSfd);
+    for (ii = 0; ii < nIco_ICtrl_JS; ii++)  {
+        ico_ictl_add_fd(gIco_ICtrl_JS[ii].fd);
+    }
+    gHotplugFd = ico_ictl_hotplug_init();
+    if (gHotplugFd >= 0)    {
+        ico_ictl_add_fd(gHotplugFd);
+    }
 
     /* send configuration informations to Multi Input Manager   */
-    for (ii = 0; ii < nIco_ICtrl_JS_Input; ii++)    {
-        ico_input_mgr_device_configure_input(
-                gIco_ICtrl_Mng.Wayland_InputMgr, gIco_ICtrl_JS.device, gIco_ICtrl_JS.type,
-                gIco_ICtrl_JS_Input[ii].name, gIco_ICtrl_JS_Input[ii].input,
-                gIco_ICtrl_JS_Input[ii].code[0].name, gIco_ICtrl_JS_Input[ii].code[0].code);
-        for (jj = 1; jj < 20; jj++)     {
-            if (gIco_ICtrl_JS_Input[ii].code[jj].code == 0) break;
-            ico_input_mgr_device_configure_code(
-                    gIco_ICtrl_Mng.Wayland_InputMgr, gIco_ICtrl_JS.device,
-                    gIco_ICtrl_JS_Input[ii].input, gIco_ICtrl_JS_Input[ii].code[jj].name,
-                    gIco_ICtrl_JS_Input[ii].code[jj].code);
-        }
+    for (ii = 0; ii < nIco_ICtrl_JS; ii++)  {
+        ico_ictl_js_configure(&gIco_ICtrl_JS[ii]);
     }
+    ico_ictl_wayland_flush();
 
     /* signal init  */
     sigint.sa_handler = signal_int;
     sigemptyset(&sigint.sa_mask);
     sigint.sa_flags = SA_RESETHAND;
     sigaction(SIGINT, &sigint, NULL);
+    sigusr1.sa_handler = signal_usr1;
+    sigemptyset(&sigusr1.sa_mask);
+    sigusr1.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &sigusr1, NULL);
 
     /* main loop    */
+    ico_ictl_latency_init(&gLatRead, "event-read");
+    ico_ictl_latency_init(&gLatFlush, "event-flush");
+    clock_gettime(CLOCK_MONOTONIC, &gStartTime);
     while (gRunning) {
         ret = ico_ictl_wayland_iterate(ev_ret, 200);
+        if (gDumpLatency)   {
+            gDumpLatency = 0;
+            ico_ictl_latency_dump();
+        }
         for (ii = 0; ii < ret; ii++) {
-            if (ev_ret[ii].data.fd == JSfd) {
-                ico_ictl_js_read(JSfd);
+            if ((gHotplugFd >= 0) && (ev_ret[ii].data.fd == gHotplugFd))    {
+                ico_ictl_hotplug();
+                continue;
+            }
+            for (jj = 0; jj < nIco_ICtrl_JS; jj++)  {
+                if (ev_ret[ii].data.fd == gIco_ICtrl_JS[jj].fd) {
+                    ico_ictl_js_read(&gIco_ICtrl_JS[jj]);
+                    break;
+                }
             }
         }
     }
+    for (ii = 0; ii < nIco_ICtrl_JS; ii++)  {
+        ico_ictl_js_print_stat(&gIco_ICtrl_JS[ii]);
+    }
+    INFO_PRINT("flush=%u deferred=%u",
+               gIco_ICtrl_Mng.FlushCount, gIco_ICtrl_Mng.FlushDefer);
+    ico_ictl_latency_dump();
     ico_ictl_wayland_finish();
 
     exit(0);
@@ -651,7 +1558,12 @@ int main(int argc, char *argv[])
 
 static void PrintUsage(const char *pName)
 {
-    fprintf( stderr, "Usage: %s [-h] [-d] DeviceName\n", pName );
+    fprintf( stderr, "Usage: %s [-h] [-d] [-l] [-b] [-e] [-n] [DeviceName]\n", pName );
+    fprintf( stderr, "       DeviceName: name of first device(default is name in conf file)\n");
+    fprintf( stderr, "       -b: drain mode(read all events of device at a wakeup)\n");
+    fprintf( stderr, "       -e: use evdev(/dev/input/eventN) instead of /dev/input/jsN\n");
+    fprintf( stderr, "       -n: no kernel filter of unused codes(evdev, to compare wakeups)\n");
+    fprintf( stderr, "       SIGUSR1 prints latency(p50/p99/p99.9) of event read and flush\n");
     fprintf( stderr, "       ex)\n");
     fprintf( stderr, "          %s \"Driving Force GT\"\n", pName);
 }
@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2013, TOYOTA MOTOR CORPORATION.
+ *
+ * This program is licensed under the terms and conditions of the
+ * Apache License, version 2.0.  The full text of the Apache License is at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ */
+/**
+ * @brief   Device Input Controllers(latency histogram)
+ *          log-linear histogram of latency from kernel event timestamp,
+ *          shared by joystick and touchpanel
+ *
+ * @date    Oct-16-2026
+ */
+
+#include    <stdio.h>
+#include    <string.h>
+#include    <time.h>
+
+#include    "ico_ictl-latency.h"
+
+/* prototype of static function             */
+static int ico_ictl_latency_index(unsigned long long usec);
+static unsigned int ico_ictl_latency_upper(int idx);
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief   ico_ictl_latency_now
+ *          current time of the clock of input events(EVIOCSCLOCKID)
+ *
+ * @param       nothing
+ * @return      current time(CLOCK_MONOTONIC, micro-sec)
+ */
+/*--------------------------------------------------------------------------*/
+unsigned long long
+ico_ictl_latency_now(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned long long)now.tv_sec * 1000000ULL +
+           (unsigned long long)(now.tv_nsec / 1000);
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief   ico_ictl_latency_init
+ *          initialize latency histogram
+ *
+ * @param[out]  lat         histogram
+ * @param[in]   name        name of measured section
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+void
+ico_ictl_latency_init(Ico_ICtl_Latency *lat, const char *name)
+{
+    memset(lat, 0, sizeof(Ico_ICtl_Latency));
+    lat->name = name;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief   ico_ictl_latency_add
+ *          add a sample to histogram(no system call, no lock)
+ *
+ * @param[in,out] lat       histogram
+ * @param[in]   start       event time(us)
+ * @param[in]   end         delivery time(us)
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+void
+ico_ictl_latency_add(Ico_ICtl_Latency *lat, unsigned long long start,
+                     unsigned long long end)
+{
+    unsigned long long  usec;
+
+    /* event time of other clock(EVIOCSCLOCKID not supported) is ignored  */
+    if ((start == 0) || (end < start))  {
+        return;
+    }
+    usec = end - start;
+    lat->bucket[ico_ictl_latency_index(usec)] ++;
+    lat->count ++;
+    lat->sum += usec;
+    if (usec > lat->max)    {
+        lat->max = (usec > 0xffffffffULL) ? 0xffffffffU : (unsigned int)usec;
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief   ico_ictl_latency_percentile
+ *          latency of percentile(upper bound of bucket, error is 12.5%)
+ *
+ * @param[in]   lat         histogram
+ * @param[in]   permille    percentile x10(500:p50, 990:p99, 999:p99.9)
+ * @return      latency(us)
+ */
+/*--------------------------------------------------------------------------*/
+unsigned int
+ico_ictl_latency_percentile(const Ico_ICtl_Latency *lat, int permille)
+{
+    unsigned long long  target;
+    unsigned long long  sum = 0;
+    unsigned int        upper;
+    int                 ii;
+
+    if (lat->count == 0)    {
+        return 0;
+    }
+    target = ((unsigned long long)lat->count * permille + 999) / 1000;
+    if (target == 0)    target = 1;
+    for (ii = 0; ii < ICO_ICTL_LATENCY_BUCKET; ii++)    {
+        sum += lat->bucket[ii];
+        if (sum >= target)  {
+            upper = ico_ictl_latency_upper(ii);
+            return (upper < lat->max) ? upper : lat->max;
+        }
+    }
+    return lat->max;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief   ico_ictl_latency_format
+ *          summary of histogram for log and runtime dump(SIGUSR1)
+ *
+ * @param[in]   lat         histogram
+ * @param[out]  buf         string buffer
+ * @param[in]   size        size of buffer
+ * @return      length of string
+ */
+/*--------------------------------------------------------------------------*/
+int
+ico_ictl_latency_format(const Ico_ICtl_Latency *lat, char *buf, int size)
+{
+    return snprintf(buf, size,
+                    "latency(%s) count=%u avg=%uus p50=%uus p99=%uus p99.9=%uus max=%uus",
+                    lat->name, lat->count,
+                    (lat->count > 0) ? (unsigned int)(lat->sum / lat->count) : 0,
+                    ico_ictl_latency_percentile(lat, 500),
+                    ico_ictl_latency_percentile(lat, 990),
+                    ico_ictl_latency_percentile(lat, 999),
+                    lat->max);
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief   ico_ictl_latency_index
+ *          bucket of latency
+ *
+ * @param[in]   usec        latency(us)
+ * @return      bucket index
+ */
+/*--------------------------------------------------------------------------*/
+static int
+ico_ictl_latency_index(unsigned long long usec)
+{
+    int     msb;
+    int     idx;
+
+    if (usec < (ICO_ICTL_LATENCY_SUB * 2))  {
+        return (int)usec;
+    }
+    /* 3 bits under the most significant bit select sub bucket  */
+    msb = 63 - __builtin_clzll(usec);
+    idx = (msb - 2) * ICO_ICTL_LATENCY_SUB + (int)((usec >> (msb - 3)) & 7);
+    return (idx < ICO_ICTL_LATENCY_BUCKET) ? idx : (ICO_ICTL_LATENCY_BUCKET - 1);
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief   ico_ictl_latency_upper
+ *          max latency of bucket
+ *
+ * @param[in]   idx         bucket index
+ * @return      latency(us)
+ */
+/*--------------------------------------------------------------------------*/
+static unsigned int
+ico_ictl_latency_upper(int idx)
+{
+    int     msb;
+    int     sub;
+
+    if (idx < (ICO_ICTL_LATENCY_SUB * 2))   {
+        return (unsigned int)idx;
+    }
+    msb = idx / ICO_ICTL_LATENCY_SUB + 2;
+    sub = idx % ICO_ICTL_LATENCY_SUB;
+    return (unsigned int)((((unsigned long long)(ICO_ICTL_LATENCY_SUB + sub + 1))
+                           << (msb - 3)) - 1);
+}
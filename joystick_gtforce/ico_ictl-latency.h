@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2013, TOYOTA MOTOR CORPORATION.
+ *
+ * This program is licensed under the terms and conditions of the
+ * Apache License, version 2.0.  The full text of the Apache License is at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ */
+/**
+ * @brief   header file of latency histogram of Input Controllers
+ *
+ * @date    Oct-16-2026
+ */
+
+#ifndef _ICO_ICTL_LATENCY_H_
+#define _ICO_ICTL_LATENCY_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* histogram buckets: 1us step under 16us, then 8 buckets per power of 2(12.5%) */
+#define ICO_ICTL_LATENCY_SUB        (8)         /* sub buckets of power of 2        */
+#define ICO_ICTL_LATENCY_BUCKET     (240)       /* number of buckets(to 2^32 us)    */
+
+/* latency histogram(us)        */
+typedef struct  _Ico_ICtl_Latency   {
+    const char              *name;              /* name of measured section         */
+    unsigned int            count;              /* number of samples                */
+    unsigned int            max;                /* max latency(us)                  */
+    unsigned long long      sum;                /* total latency(us)                */
+    unsigned int            bucket[ICO_ICTL_LATENCY_BUCKET];
+}   Ico_ICtl_Latency;
+
+/* function prototype           */
+                                                /* current time(CLOCK_MONOTONIC, us)*/
+unsigned long long ico_ictl_latency_now(void);
+                                                /* initialize histogram             */
+void ico_ictl_latency_init(Ico_ICtl_Latency *lat, const char *name);
+                                                /* add a sample(from start to end)  */
+void ico_ictl_latency_add(Ico_ICtl_Latency *lat, unsigned long long start,
+                          unsigned long long end);
+                                                /* latency of percentile(x10)       */
+unsigned int ico_ictl_latency_percentile(const Ico_ICtl_Latency *lat, int permille);
+                                                /* summary string(p50/p99/p99.9)    */
+int ico_ictl_latency_format(const Ico_ICtl_Latency *lat, char *buf, int size);
+
+#ifdef __cplusplus
+}
+#endif
+#endif  /* _ICO_ICTL_LATENCY_H_ */
@@ -66,6 +66,11 @@ typedef struct  _Ico_ICtl_Mng   {
     int                         WaylandFd;          /* file descriptor of Wayland   */
     int                         ICTL_EFD;           /* descriptor of epoll          */
 
+    /* coalesced flush          */
+    int                         FlushWait;          /* wait EPOLLOUT for flush      */
+    unsigned int                FlushCount;         /* number of flush              */
+    unsigned int                FlushDefer;         /* number of deferred flush     */
+
 }   Ico_ICtl_Mng;
 
 /* function prototype           */
@@ -75,12 +80,15 @@ void ico_ictl_wayland_finish(void);             /* finish wayland connection
                                                 /* iterate wayland connection       */
 int ico_ictl_wayland_iterate(struct epoll_event *ev_ret, int timeout);
 int ico_ictl_add_fd(int fd);                    /* add file descriptor              */
+int ico_ictl_wayland_flush(void);               /* flush requests of input batch    */
 
 /* macro for debug              */
 extern const char *dbg_curtime(void);
 extern int  mDebug;
 #define DEBUG_PRINT(fmt, ...)   \
     {if (mDebug) {fprintf(stderr, "%sDBG> "fmt" (%s:%d)\n",dbg_curtime(),##__VA_ARGS__,__FILE__,__LINE__); fflush(stderr);}}
+#define INFO_PRINT(fmt, ...)    \
+    {fprintf(stderr, "%sINF> "fmt"\n",dbg_curtime(),##__VA_ARGS__); fflush(stderr);}
 #define ERROR_PRINT(fmt, ...)   \
     {fprintf(stderr, "%sERR> "fmt" (%s:%d)\n",dbg_curtime(),##__VA_ARGS__,__FILE__,__LINE__); fflush(stderr);}
 
@@ -27,6 +27,8 @@
 static void ico_ictl_wayland_globalcb(void *data, struct wl_registry *registry,
                                       uint32_t wldispid, const char *event,
                                       uint32_t version);
+/* flush requests, wait EPOLLOUT if the socket would block  */
+static int ico_ictl_wayland_send(void);
 
 /* table/variable                           */
 extern Ico_ICtl_Mng         gIco_ICtrl_Mng;
@@ -44,7 +46,7 @@ static const struct wl_registry_listener registry_listener = {
  * @param[in]   display             display to connect
  * @param[in]   callback            callback function
  * @return      result
- * @retval      ICO_ICTL_EOK        Success
+ * @retval      ICO_ICTL_OK         Success
  * @retval      ICO_ICTL_ERR        Failed
  */
 /*--------------------------------------------------------------------------*/
@@ -151,15 +153,25 @@ ico_ictl_wayland_iterate(struct epoll_event *ev_ret, int timeout)
     int ii = 0;
 
     memset(ev_ret, 0, sizeof(struct epoll_event) * ICO_ICTL_EVENT_NUM);
-    wl_display_flush(gIco_ICtrl_Mng.Wayland_Display);
+    /* requests queued out of input batch(e.g. by dispatch) are sent    */
+    /* before blocking, a deferred flush is resumed by EPOLLOUT         */
+    if (! gIco_ICtrl_Mng.FlushWait) {
+        ico_ictl_wayland_send();
+    }
 
     while (1) {
         if ((nfds = epoll_wait( gIco_ICtrl_Mng.ICTL_EFD, ev_ret,
                                        ICO_ICTL_EVENT_NUM, timeout)) > 0) {
             for (ii = 0; ii < nfds; ii++) {
                 if (ev_ret[ii].data.fd == gIco_ICtrl_Mng.WaylandFd) {
-                    wl_display_dispatch(gIco_ICtrl_Mng.Wayland_Display);
-                    DEBUG_PRINT( "ico_ictl_wayland_iterate: Exit wayland fd");
+                    if (ev_ret[ii].events & EPOLLOUT)   {
+                        /* socket is writable, resume deferred flush    */
+                        ico_ictl_wayland_send();
+                    }
+                    if (ev_ret[ii].events & (EPOLLIN|EPOLLERR|EPOLLHUP))  {
+                        wl_display_dispatch(gIco_ICtrl_Mng.Wayland_Display);
+                        DEBUG_PRINT( "ico_ictl_wayland_iterate: Exit wayland fd");
+                    }
                 }
             }
             return nfds;
@@ -170,6 +182,76 @@ ico_ictl_wayland_iterate(struct epoll_event *ev_ret, int timeout)
     }
 }
 
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief   ico_ictl_wayland_flush
+ *          flush requests of an input batch to wayland by one
+ *          wl_display_flush(). if the socket would block, the flush is
+ *          deferred until the Wayland descriptor becomes writable(EPOLLOUT)
+ *
+ * @param       nothing
+ * @return      result
+ * @retval      ICO_ICTL_OK         Success(flushed or deferred)
+ * @retval      ICO_ICTL_ERR        Failed
+ */
+/*--------------------------------------------------------------------------*/
+int
+ico_ictl_wayland_flush(void)
+{
+    gIco_ICtrl_Mng.FlushCount ++;
+    return ico_ictl_wayland_send();
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief   ico_ictl_wayland_send
+ *          wl_display_flush(), if the socket would block, wait until
+ *          the Wayland descriptor becomes writable(EPOLLOUT)
+ *
+ * @param       nothing
+ * @return      result
+ * @retval      ICO_ICTL_OK         Success(flushed or deferred)
+ * @retval      ICO_ICTL_ERR        Failed
+ */
+/*--------------------------------------------------------------------------*/
+static int
+ico_ictl_wayland_send(void)
+{
+    struct epoll_event  ev;
+
+    if (wl_display_flush(gIco_ICtrl_Mng.Wayland_Display) >= 0)  {
+        if (gIco_ICtrl_Mng.FlushWait)   {
+            /* all requests sent, stop waiting EPOLLOUT */
+            memset(&ev, 0, sizeof(ev));
+            ev.events = EPOLLIN;
+            ev.data.fd = gIco_ICtrl_Mng.WaylandFd;
+            epoll_ctl(gIco_ICtrl_Mng.ICTL_EFD, EPOLL_CTL_MOD,
+                      gIco_ICtrl_Mng.WaylandFd, &ev);
+            gIco_ICtrl_Mng.FlushWait = 0;
+        }
+        return ICO_ICTL_OK;
+    }
+    if (errno != EAGAIN)    {
+        ERROR_PRINT("ico_ictl_wayland_send: Leave(ERR), Flush Error[%d]", errno);
+        return ICO_ICTL_ERR;
+    }
+    if (! gIco_ICtrl_Mng.FlushWait) {
+        /* socket buffer full, wait until writable  */
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN | EPOLLOUT;
+        ev.data.fd = gIco_ICtrl_Mng.WaylandFd;
+        if (epoll_ctl(gIco_ICtrl_Mng.ICTL_EFD, EPOLL_CTL_MOD,
+                      gIco_ICtrl_Mng.WaylandFd, &ev) != 0)    {
+            ERROR_PRINT("ico_ictl_wayland_send: Leave(ERR), Epoll ctl Error");
+            return ICO_ICTL_ERR;
+        }
+        gIco_ICtrl_Mng.FlushWait = 1;
+        gIco_ICtrl_Mng.FlushDefer ++;
+    }
+    DEBUG_PRINT("ico_ictl_wayland_send: deferred(EAGAIN)");
+    return ICO_ICTL_OK;
+}
+
 /*--------------------------------------------------------------------------*/
 /**
  * @brief   ico_ictl_add_fd
@@ -177,7 +259,7 @@ ico_ictl_wayland_iterate(struct epoll_event *ev_ret, int timeout)
  *
  * @param[in]   fd                  File descriptor
  * @return      result
- * @retval      ICO_ICTL_EOK        Success
+ * @retval      ICO_ICTL_OK         Success
  * @retval      ICO_ICTL_ERR        Failed
  */
 /*--------------------------------------------------------------------------*/
@@ -0,0 +1,284 @@
+/*
+ * Copyright (c) 2013, TOYOTA MOTOR CORPORATION.
+ *
+ * This program is licensed under the terms and conditions of the
+ * Apache License, version 2.0.  The full text of the Apache License is at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ */
+/**
+ * @brief   Micro benchmark of touchpanel calibration
+ *          compare per-axis division(old calibration_event) with the
+ *          fixed-point affine transform(scalar and batch), and error of
+ *          the fixed-point transform from the exact(double) affine fit
+ *
+ * @date    Oct-16-2026
+ */
+
+#include    "ico_ictl-touch_egalax.h"
+
+#define BENCH_PAIRS     (64)            /* X/Y pairs in a read buffer(events[128])  */
+#define BENCH_LOOP      (200000)        /* default number of read buffers           */
+
+int             mDebug = 0;
+
+/* configuration of the old per-axis calibration(egalax_calibration.conf)  */
+static int      mDispWidth = 1920;
+static int      mDispHeight = 1080;
+static int      mPosX[4] = { 1958, 77, 1924, 99 };
+static int      mPosY[4] = { 114, 125, 1879, 1852 };
+static int      mXlow, mXheigh, mYlow, mYheigh;
+static int      mRevX, mRevY;
+static int      mTrans = 0;
+
+static volatile int mSink;
+
+/* old calibration_event() of ABS_X     */
+static int
+legacy_x(int value, int *code)
+{
+    int     out;
+
+    out = mDispWidth * (value - mXlow) / (mXheigh - mXlow);
+    if (mRevX)  {
+        out = mDispWidth - out;
+    }
+    if (out < 0)            out = 0;
+    if (out >= mDispWidth)  out = mDispWidth - 1;
+
+    *code = ABS_X;
+    if (mTrans == 90)   {
+        *code = ABS_Y;
+        out = mDispWidth - out - 1;
+    }
+    else if (mTrans == 180) {
+        out = mDispWidth - out - 1;
+    }
+    else if (mTrans == 270) {
+        *code = ABS_Y;
+    }
+    return out;
+}
+
+/* old calibration_event() of ABS_Y     */
+static int
+legacy_y(int value, int *code)
+{
+    int     out;
+
+    out = mDispHeight * (value - mYlow) / (mYheigh - mYlow);
+    if (mRevY)  {
+        out = mDispHeight - out;
+    }
+    if (out < 0)            out = 0;
+    if (out >= mDispHeight) out = mDispHeight - 1;
+
+    *code = ABS_Y;
+    if (mTrans == 90)   {
+        *code = ABS_X;
+    }
+    else if (mTrans == 180) {
+        out = mDispHeight - out - 1;
+    }
+    else if (mTrans == 270) {
+        *code = ABS_X;
+        out = mDispHeight - out - 1;
+    }
+    return out;
+}
+
+/* old setup_program() of per-axis range    */
+static void
+legacy_setup(void)
+{
+    int     px[4], py[4];
+
+    memcpy(px, mPosX, sizeof(px));
+    memcpy(py, mPosY, sizeof(py));
+    if (px[0] > px[1])  {
+        mRevX = 1;
+        mXlow = (px[1] + px[3]) / 2;
+        mXheigh = (px[0] + px[2]) / 2;
+    }
+    else    {
+        mXlow = (px[0] + px[2]) / 2;
+        mXheigh = (px[1] + px[3]) / 2;
+    }
+    if (py[0] > py[2])  {
+        mRevY = 1;
+        mYlow = (py[2] + py[3]) / 2;
+        mYheigh = (py[0] + py[1]) / 2;
+    }
+    else    {
+        mYlow = (py[0] + py[1]) / 2;
+        mYheigh = (py[2] + py[3]) / 2;
+    }
+}
+
+/* exact affine fit of 4 corners by least squares(double), same as fixed-point fit  */
+static void
+exact_fit(double *cx, double *cy)
+{
+    double  m[3][3], vx[3], vy[3], row[3];
+    double  det, t[3][3];
+    double  dx[4] = { 0, 0, 0, 0 };
+    double  dy[4] = { 0, 0, 0, 0 };
+    int     ii, jj, kk;
+
+    dx[1] = dx[3] = mDispWidth;
+    dy[2] = dy[3] = mDispHeight;
+    memset(m, 0, sizeof(m));
+    memset(vx, 0, sizeof(vx));
+    memset(vy, 0, sizeof(vy));
+    for (kk = 0; kk < 4; kk++)  {
+        row[0] = mPosX[kk];
+        row[1] = mPosY[kk];
+        row[2] = 1.0;
+        for (ii = 0; ii < 3; ii++)  {
+            for (jj = 0; jj < 3; jj++)  m[ii][jj] += row[ii] * row[jj];
+            vx[ii] += row[ii] * dx[kk];
+            vy[ii] += row[ii] * dy[kk];
+        }
+    }
+    /* normal equations by Cramer's rule    */
+    det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+        - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+        + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+    for (kk = 0; kk < 3; kk++)  {
+        memcpy(t, m, sizeof(t));
+        for (ii = 0; ii < 3; ii++)  t[ii][kk] = vx[ii];
+        cx[kk] = (t[0][0] * (t[1][1] * t[2][2] - t[1][2] * t[2][1])
+                - t[0][1] * (t[1][0] * t[2][2] - t[1][2] * t[2][0])
+                + t[0][2] * (t[1][0] * t[2][1] - t[1][1] * t[2][0])) / det;
+        memcpy(t, m, sizeof(t));
+        for (ii = 0; ii < 3; ii++)  t[ii][kk] = vy[ii];
+        cy[kk] = (t[0][0] * (t[1][1] * t[2][2] - t[1][2] * t[2][1])
+                - t[0][1] * (t[1][0] * t[2][2] - t[1][2] * t[2][0])
+                + t[0][2] * (t[1][0] * t[2][1] - t[1][1] * t[2][0])) / det;
+    }
+}
+
+static double
+elapsed_ns(struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) * 1e9 + (now.tv_nsec - start->tv_nsec);
+}
+
+int
+main(int argc, char *argv[])
+{
+    calibration_matrix  matrix;
+    int     dispX[4] = { 0, 0, 0, 0 };
+    int     dispY[4] = { 0, 0, 0, 0 };
+    int     rawx[BENCH_PAIRS], rawy[BENCH_PAIRS];
+    int     outx[BENCH_PAIRS], outy[BENCH_PAIRS];
+    int     loop = BENCH_LOOP;
+    int     ii, jj;
+    int     code, sum, diff, maxdiff;
+    double  nevent, ns;
+    double  cx[3], cy[3], ex, ey, maxerr;
+    struct timespec start;
+
+    for (ii = 1; ii < argc; ii++)   {
+        if ((strcmp(argv[ii], "-n") == 0) && (ii < (argc-1)))   {
+            ii++;
+            loop = strtol(argv[ii], (char **)0, 0);
+        }
+        else    {
+            fprintf(stderr, "Usage: %s [-n number_of_read_buffer]\n", argv[0]);
+            exit(0);
+        }
+    }
+    if (loop <= 0)  loop = BENCH_LOOP;
+
+    legacy_setup();
+    dispX[1] = mDispWidth;
+    dispX[3] = mDispWidth;
+    dispY[2] = mDispHeight;
+    dispY[3] = mDispHeight;
+    if (calibration_fit(&matrix, mPosX, mPosY, dispX, dispY, 4,
+                        mDispWidth, mDispHeight) != 0)  {
+        fprintf(stderr, "calibration fit failed\n");
+        exit(1);
+    }
+
+    srand(1);
+    for (ii = 0; ii < BENCH_PAIRS; ii++)    {
+        rawx[ii] = 50 + rand() % 1950;
+        rawy[ii] = 100 + rand() % 1800;
+    }
+    nevent = (double)loop * BENCH_PAIRS * 2;
+
+    /* old: multiply and divide per axis event  */
+    sum = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (jj = 0; jj < loop; jj++)   {
+        for (ii = 0; ii < BENCH_PAIRS; ii++)    {
+            sum += legacy_x(rawx[ii] ^ (jj & 1), &code);
+            sum += legacy_y(rawy[ii] ^ (jj & 1), &code);
+        }
+    }
+    ns = elapsed_ns(&start);
+    mSink = sum;
+    printf("legacy per-axis     : %6.2f ns/event\n", ns / nevent);
+
+    /* affine, one pair per call    */
+    sum = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (jj = 0; jj < loop; jj++)   {
+        for (ii = 0; ii < BENCH_PAIRS; ii++)    {
+            calibration_apply(&matrix, rawx[ii] ^ (jj & 1), rawy[ii] ^ (jj & 1),
+                              &outx[ii], &outy[ii]);
+        }
+        sum += outx[jj % BENCH_PAIRS] + outy[jj % BENCH_PAIRS];
+    }
+    ns = elapsed_ns(&start);
+    mSink = sum;
+    printf("affine scalar       : %6.2f ns/event\n", ns / nevent);
+
+    /* affine, whole read buffer per call   */
+    sum = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (jj = 0; jj < loop; jj++)   {
+        rawx[jj % BENCH_PAIRS] ^= 1;
+        calibration_apply_batch(&matrix, rawx, rawy, outx, outy, BENCH_PAIRS);
+        sum += outx[jj % BENCH_PAIRS] + outy[jj % BENCH_PAIRS];
+    }
+    ns = elapsed_ns(&start);
+    mSink = sum;
+    printf("affine batch(%d)    : %6.2f ns/event\n", BENCH_PAIRS, ns / nevent);
+
+    /* difference of result(skew of 4 points is corrected by affine) */
+    maxdiff = 0;
+    calibration_apply_batch(&matrix, rawx, rawy, outx, outy, BENCH_PAIRS);
+    for (ii = 0; ii < BENCH_PAIRS; ii++)    {
+        diff = outx[ii] - legacy_x(rawx[ii], &code);
+        if (diff < 0)   diff = -diff;
+        if (diff > maxdiff) maxdiff = diff;
+        diff = outy[ii] - legacy_y(rawy[ii], &code);
+        if (diff < 0)   diff = -diff;
+        if (diff > maxdiff) maxdiff = diff;
+    }
+    printf("max difference      : %d pixel(from legacy per-axis)\n", maxdiff);
+
+    /* rounding of fixed-point(Q16) transform, from exact affine fit    */
+    exact_fit(cx, cy);
+    maxerr = 0.0;
+    for (ii = 0; ii < BENCH_PAIRS; ii++)    {
+        ex = cx[0] * rawx[ii] + cx[1] * rawy[ii] + cx[2];
+        ey = cy[0] * rawx[ii] + cy[1] * rawy[ii] + cy[2];
+        if ((ex < 0.0) || (ex > (mDispWidth - 1)) || (ey < 0.0) || (ey > (mDispHeight - 1)))  {
+            /* clipped to screen    */
+            continue;
+        }
+        ex = (ex > outx[ii]) ? (ex - outx[ii]) : (outx[ii] - ex);
+        ey = (ey > outy[ii]) ? (ey - outy[ii]) : (outy[ii] - ey);
+        if (ex > maxerr)    maxerr = ex;
+        if (ey > maxerr)    maxerr = ey;
+    }
+    printf("max fixed-point err : %.3f pixel(from exact affine)\n", maxerr);
+    exit(0);
+}
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2013, TOYOTA MOTOR CORPORATION.
+ *
+ * This program is licensed under the terms and conditions of the
+ * Apache License, version 2.0.  The full text of the Apache License is at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ */
+/**
+ * @brief   Recorded touches for touchpanel calibration tool
+ *          write events of touches(same as event device) to stdout for
+ *          scripted calibration without touchpanel, touches of a point
+ *          continue until the point is stable as the tool, for example
+ *          test-calibration_record -points 9 | \
+ *              ico_ictl-egalax_calibration -points 9 -replay - -report fit.txt
+ *          -repeat omits X/Y same as the last touch(with BTN_TOUCH), as the
+ *          event device
+ *
+ * @date    Oct-16-2026
+ */
+
+#include    "ico_ictl-touch_egalax.h"
+
+#define RECORD_TOUCH_MS (50)            /* time of a touch                  */
+#define RECORD_NEXT_MS  (500)           /* time to next touch               */
+
+int             mDebug = 0;
+
+/* touchpanel of test-calibration_bench(X is reversed)  */
+static int      mDispWidth = 1920;
+static int      mDispHeight = 1080;
+static int      mPosX[3] = { 1958, 77, 1924 };      /* Top-Left, Top-Right, Bottom-Left */
+static int      mPosY[3] = { 114, 125, 1879 };
+
+static double   mNoise = 1.0;           /* sigma of touch(raw)              */
+static int      mOutlier = 0;           /* every N-th touch is outlier      */
+static int      mButton = 1;            /* BTN_TOUCH is reported            */
+static int      mRepeat = 0;            /* X/Y same as last is not reported */
+static int      mLastX = -1;            /* last reported X                  */
+static int      mLastY = -1;            /* last reported Y                  */
+static unsigned long long   mUsec = 1000000ULL;
+
+/* gaussian noise(sum of 12 uniform), no libm  */
+static double
+noise(void)
+{
+    double  sum = 0.0;
+    int     ii;
+
+    for (ii = 0; ii < 12; ii++) {
+        sum += (double)rand() / RAND_MAX;
+    }
+    return (sum - 6.0) * mNoise;
+}
+
+static void
+put_event(int type, int code, int value)
+{
+    struct input_event  event;
+
+    memset(&event, 0, sizeof(event));
+    event.time.tv_sec = mUsec / 1000000ULL;
+    event.time.tv_usec = mUsec % 1000000ULL;
+    event.type = type;
+    event.code = code;
+    event.value = value;
+    fwrite(&event, sizeof(event), 1, stdout);
+}
+
+/* a touch at screen position       */
+static void
+put_touch(int x, int y, int outlier, int *outx, int *outy)
+{
+    double  rx, ry;
+
+    rx = mPosX[0] + (double)(mPosX[1] - mPosX[0]) * x / mDispWidth
+                  + (double)(mPosX[2] - mPosX[0]) * y / mDispHeight + noise();
+    ry = mPosY[0] + (double)(mPosY[1] - mPosY[0]) * x / mDispWidth
+                  + (double)(mPosY[2] - mPosY[0]) * y / mDispHeight + noise();
+    if (outlier)    {
+        rx += 150.0;
+        ry -= 90.0;
+    }
+
+    /* kernel drops X/Y same as the last value  */
+    if ((! mRepeat) || ((int)rx != mLastX)) {
+        put_event(EV_ABS, ABS_X, (int)rx);
+    }
+    if ((! mRepeat) || ((int)ry != mLastY)) {
+        put_event(EV_ABS, ABS_Y, (int)ry);
+    }
+    mLastX = (int)rx;
+    mLastY = (int)ry;
+    if (mButton)    {
+        put_event(EV_KEY, BTN_TOUCH, 1);
+    }
+    put_event(EV_SYN, SYN_REPORT, 0);
+    mUsec += RECORD_TOUCH_MS * 1000ULL;
+    if (mButton)    {
+        put_event(EV_KEY, BTN_TOUCH, 0);
+    }
+    else    {
+        /* second report ends a touch without BTN_TOUCH */
+        put_event(EV_ABS, ABS_X, (int)rx);
+        put_event(EV_ABS, ABS_Y, (int)ry);
+    }
+    put_event(EV_SYN, SYN_REPORT, 0);
+    mUsec += RECORD_NEXT_MS * 1000ULL;
+
+    *outx = (int)rx;
+    *outy = (int)ry;
+}
+
+int
+main(int argc, char *argv[])
+{
+    int     points = 4;
+    int     bufX[CALIBRATOIN_TOUCH_MAX];
+    int     bufY[CALIBRATOIN_TOUCH_MAX];
+    int     x, y;
+    int     num = 0;
+    int     ii, jj;
+
+    for (ii = 1; ii < argc; ii++)   {
+        if ((strcmp(argv[ii], "-points") == 0) && (ii < (argc-1)))  {
+            ii++;
+            points = strtol(argv[ii], (char **)0, 0);
+        }
+        else if ((strcmp(argv[ii], "-noise") == 0) && (ii < (argc-1)))  {
+            ii++;
+            mNoise = atof(argv[ii]);
+        }
+        else if ((strcmp(argv[ii], "-outlier") == 0) && (ii < (argc-1)))    {
+            ii++;
+            mOutlier = strtol(argv[ii], (char **)0, 0);
+        }
+        else if (strcmp(argv[ii], "-nobutton") == 0)    {
+            mButton = 0;
+        }
+        else if (strcmp(argv[ii], "-repeat") == 0)  {
+            mRepeat = 1;
+        }
+        else    {
+            fprintf(stderr, "Usage: %s [-points 4|9|16|25][-noise sigma]"
+                    "[-outlier n][-nobutton][-repeat]\n", argv[0]);
+            exit(0);
+        }
+    }
+    if ((points != 4) && (points != 9) && (points != 16) && (points != 25)) {
+        points = 4;
+    }
+    if (! mButton)  {
+        /* touch without BTN_TOUCH ends at the second report of same X/Y    */
+        mRepeat = 0;
+    }
+    srand(1);
+
+    for (ii = 0; ii < points; ii++) {
+        calibration_point(points, ii, mDispWidth, mDispHeight, &x, &y);
+        for (jj = 0; jj < CALIBRATOIN_TOUCH_MAX; )  {
+            num ++;
+            put_touch(x, y, (mOutlier > 0) && ((num % mOutlier) == 0), &bufX[jj], &bufY[jj]);
+            jj ++;
+            if ((jj >= CALIBRATOIN_TOUCH_MIN) &&
+                calibration_stable(bufX, jj, CALIBRATOIN_TOUCH_CONVERGE) &&
+                calibration_stable(bufY, jj, CALIBRATOIN_TOUCH_CONVERGE))   {
+                break;
+            }
+        }
+    }
+    fflush(stdout);
+    exit(0);
+}
@@ -118,6 +118,13 @@ init_device(const char *device)
     strcpy(uinputDevice.name, device);
     uinputDevice.absmax[ABS_X] = 1920;
     uinputDevice.absmax[ABS_Y] = 1080;
+    if (mTouch == 3)    {
+        /* joystick axes, value is -1, 0 or 1   */
+        for (ii = ABS_X; ii <= ABS_RZ; ii++)    {
+            uinputDevice.absmin[ii] = -1;
+            uinputDevice.absmax[ii] = 1;
+        }
+    }
 
     /* uinput device configuration  */
     if (write(uifd, &uinputDevice, sizeof(uinputDevice)) < (int)sizeof(uinputDevice)) {
@@ -130,7 +137,18 @@ init_device(const char *device)
     /* uinput set event bits        */
     ioctl(uifd, UI_SET_EVBIT, EV_SYN);
 
-    if ((mTouch != 0) && (mTouch != 3)) {
+    if (mTouch == 3)    {
+        /* joystick(evdev), axis and button number are same as joydev   */
+        ioctl(uifd, UI_SET_EVBIT, EV_ABS);
+        for (ii = ABS_X; ii <= ABS_RZ; ii++)    {
+            ioctl(uifd, UI_SET_ABSBIT, ii);
+        }
+        ioctl(uifd, UI_SET_EVBIT, EV_KEY);
+        for (ii = 0; ii < 12; ii++) {
+            ioctl(uifd, UI_SET_KEYBIT, BTN_JOYSTICK + ii);
+        }
+    }
+    else if (mTouch != 0)   {
         ioctl(uifd, UI_SET_EVBIT, EV_ABS);
         ioctl(uifd, UI_SET_ABSBIT, ABS_X);
         ioctl(uifd, UI_SET_ABSBIT, ABS_Y);
@@ -324,6 +342,24 @@ send_event(const char *cmd)
                 fflush(stderr);
             }
         }
+        else if (mTouch == 3)   {
+            /* joystick(evdev)  */
+            if (event_key[key].type == JS_EVENT_AXIS)   {
+                event.type = EV_ABS;
+                event.code = event_key[key].code;
+            }
+            else    {
+                event.type = EV_KEY;
+                event.code = BTN_JOYSTICK + event_key[key].code;
+            }
+            event.value = convert_value(value, (char **)0, 0);
+            if (mDebug) {
+                print_log("Send Event type=%d code=%d value=%d\t# %d.%03d",
+                          event.type, event.code, event.value,
+                          (int)event.time.tv_sec, (int)(event.time.tv_usec/1000));
+                fflush(stderr);
+            }
+        }
         else    {
             event.type = event_key[key].type;
 
@@ -352,12 +388,6 @@ send_event(const char *cmd)
                               (int)event.time.tv_sec, (int)(event.time.tv_usec/1000));
                 }
                 else    {
-                    if ((event.type == EV_REL) && (event.value == 0))   {
-                        event.value = 9;
-                    }
-                    else if ((event.type == EV_KEY) && (event.code == 0))   {
-                        event.code = 9;
-                    }
                     print_log("Send Event type=%d code=%d value=%d\t# %d.%03d",
                               event.type, event.code, event.value,
                               (int)event.time.tv_sec, (int)(event.time.tv_usec/1000));
@@ -401,7 +431,7 @@ send_event(const char *cmd)
 static void
 usage(const char *prog)
 {
-    fprintf(stderr, "Usage: %s [-device=device] [{-m/-t/-j}] [-mq[=key]] [-d] [event=value] [event=value] ...\n", prog);
+    fprintf(stderr, "Usage: %s [-device=device] [{-m/-t/-j/-J}] [-mq[=key]] [-d] [event=value] [event=value] ...\n", prog);
     exit(0);
 }
 
@@ -433,7 +463,7 @@ main(int argc, char *argv[])
                 mTouch = 0;                 /* Simulate joystick            */
             }
             else if (strcmp(argv[i], "-J") == 0)   {
-                mTouch = 3;                 /* Simulate joystick, but event is mouse    */
+                mTouch = 3;                 /* Simulate joystick, but event is evdev    */
             }
             else if (strncasecmp(argv[i], "-mq", 3) == 0)   {
                 if (argv[i][3] == '=')  {
@@ -8,31 +8,93 @@
  */
 /**
  * @brief   Touchpanel(eGalax) Calibration Tool
+ *          4 corners(POSITION1-4), or N-point grid fitted by least squares
+ *          with outlier rejection(MATRIX)
+ *          touches are read from touchpanel, or from recorded events
  *
  * @date    Feb-20-2013
  */
 
 #include "ico_ictl-touch_egalax.h"
 
-/* Number of times to repeat a touch about each point   */
-#define CALIBCONF_READ_NUM  (5)
+/* End of a touch without BTN_TOUCH  */
+#define CALIBCONF_QUIET_MS  (200)       /* quiet time(ms)               */
 #define XY_COORDNATE_DELTA  (50)
 
+/* N-point calibration(grid of 3x3 to 5x5 points)       */
+#define CALIBCONF_GRID_MAX  (5)
+#define CALIBCONF_POINT_MAX (CALIBCONF_GRID_MAX * CALIBCONF_GRID_MAX)
+#define CALIBCONF_TOUCH_MAX (CALIBCONF_POINT_MAX * CALIBRATOIN_TOUCH_MAX)
+
+/* Number of events of a read       */
+#define CALIBCONF_EVENT_NUM (64)
+
+/* Residual of a calibration point  */
+typedef struct  _calibconf_result   {
+    int     used;                       /* touches used by fit          */
+    double  dx;                         /* mean residual of X(pixel)    */
+    double  dy;                         /* mean residual of Y(pixel)    */
+}   calibconf_result;
+
 /* Macro for adjust coordinate      */
 #define delta_add(x)    \
     (x) > 256 ? (x) + XY_COORDNATE_DELTA : ((x) > XY_COORDNATE_DELTA ? (x) - XY_COORDNATE_DELTA : 0);
 
 static void print_usage(const char *pName);
 static char *find_event_device(void);
-static FILE *open_conffile(void);
-static void get_coordinates(int evfd);
-static void read_event(int evfd, int *x, int *y);
+static const char *conf_path(void);
+static int conf_writable(void);
+static int conf_panel_key(const char *line);
+static int conf_calib_key(const char *line);
+static char *conf_panel_device(int npanel, int *nsect);
+static void conf_write_keys(FILE *fp);
+static int write_conffile(int npanel);
+static void get_coordinates(void);
+static int get_points(void);
+static int read_point(int dispx, int dispy);
+static void fit_residuals(void);
+static void report_points(void);
+static int write_report(const char *path);
+static void matrix_positions(void);
+static int get_event(struct input_event *event, int timeout);
+static void get_position(void);
+static void read_event(int *x, int *y);
 static void sort_data(int buff[], int left, int right);
 
 int             mDispWidth = CALIBRATION_DISP_WIDTH;
 int             mDispHeight = CALIBRATION_DISP_HEIGHT;
 int             mPosX[4];
 int             mPosY[4];
+int             mPoints = 4;                    /* number of calibration points */
+calibration_matrix  mMatrix;                    /* transform of N-point         */
+int             mFitted = 0;                    /* mMatrix is valid             */
+int             mFitUsec = 0;                   /* time of fit(us)              */
+
+/* touches of all points            */
+int             mNumTouch = 0;                  /* number of touches            */
+int             mRawX[CALIBCONF_TOUCH_MAX];     /* X coordinate of touchpanel   */
+int             mRawY[CALIBCONF_TOUCH_MAX];     /* Y coordinate of touchpanel   */
+int             mTouchX[CALIBCONF_TOUCH_MAX];   /* X coordinate of screen       */
+int             mTouchY[CALIBCONF_TOUCH_MAX];   /* Y coordinate of screen       */
+int             mInlier[CALIBCONF_TOUCH_MAX];   /* touch is used by fit         */
+int             mCount[CALIBCONF_POINT_MAX];    /* touches of each point        */
+calibconf_result    mResult[CALIBCONF_POINT_MAX];
+double          mMeanX, mMeanY;                 /* mean of |residual|           */
+double          mMaxX, mMaxY;                   /* max of |residual|            */
+int             mRejected;                      /* rejected touches             */
+
+/* input of touches                 */
+int             mEvfd = -1;                     /* event device(non-blocking)   */
+int             mEpfd = -1;                     /* epoll of event device        */
+FILE            *mReplayFp = NULL;              /* recorded events              */
+int             mEventNum = 0;                  /* number of read events        */
+int             mEventPos = 0;                  /* next event                   */
+int             mEventEnd = 0;                  /* end of recorded events       */
+unsigned long long  mFirstUsec = 0;             /* time of first event          */
+unsigned long long  mLastUsec = 0;              /* time of last event           */
+int             mLastX = -1;                    /* last X of touch(-1: unknown) */
+int             mLastY = -1;                    /* last Y of touch(-1: unknown) */
+struct input_event  mEvents[CALIBCONF_EVENT_NUM];
 
 int             mDebug = 0;
 
@@ -50,11 +112,15 @@ int             mDebug = 0;
 int
 main(int argc, char *argv[])
 {
-    int     ii, cnt;
-    int     evfd;                               /* event device fd */
+    int     ii;
+    int     npanel = 0;                         /* panel of configuration */
+    int     nsect;                              /* panels of configuration */
     char    *eventDeviceName = NULL;            /* event device name to hook */
-    FILE    *fp;
-    char    buff[128];
+    char    *confDeviceName;                    /* DEVICE of the panel */
+    char    *replayName = NULL;                 /* recorded events("-": stdin) */
+    char    *reportName = NULL;                 /* fit report */
+    struct timespec start, end;
+    struct epoll_event ev;
 
     /* Get options                      */
     for (ii = 1; ii < argc; ii++) {
@@ -89,32 +155,109 @@ main(int argc, char *argv[])
                 exit(0);
             }
         }
+        else if (strcasecmp(argv[ii], "-points") == 0)  {
+            /* Number of points(4, 9, 16 or 25) */
+            ii++;
+            if (ii >= argc) {
+                print_usage(argv[0]);
+                exit(0);
+            }
+            mPoints = strtol(argv[ii], (char **)0, 0);
+            if ((mPoints != 4) && (mPoints != 9) &&
+                (mPoints != 16) && (mPoints != 25)) {
+                print_usage(argv[0]);
+                exit(0);
+            }
+        }
+        else if (strcasecmp(argv[ii], "-panel") == 0)   {
+            /* Panel of configuration file      */
+            ii++;
+            if (ii >= argc) {
+                print_usage(argv[0]);
+                exit(0);
+            }
+            npanel = strtol(argv[ii], (char **)0, 0);
+            if ((npanel < 0) || (npanel >= CALIBRATOIN_PANEL_NUM))  {
+                print_usage(argv[0]);
+                exit(0);
+            }
+        }
+        else if (strcasecmp(argv[ii], "-replay") == 0)  {
+            /* Recorded events instead of touchpanel    */
+            ii++;
+            if (ii >= argc) {
+                print_usage(argv[0]);
+                exit(0);
+            }
+            replayName = argv[ii];
+        }
+        else if (strcasecmp(argv[ii], "-report") == 0)  {
+            /* Fit report file          */
+            ii++;
+            if (ii >= argc) {
+                print_usage(argv[0]);
+                exit(0);
+            }
+            reportName = argv[ii];
+        }
         else {
             /* Input event device name  */
             eventDeviceName = argv[ii];
         }
     }
 
-    if (eventDeviceName == NULL) {
-        /* If event device not present, get default device  */
-        eventDeviceName = find_event_device();
-        if (eventDeviceName == NULL) {
-            /* System has no touchpanel, Error  */
+    confDeviceName = conf_panel_device(npanel, &nsect);
+    if (npanel >= nsect)    {
+        fprintf(stderr, "%s: panel %d is not in %s\n", argv[0], npanel, conf_path());
+        exit(8);
+    }
+
+    if (replayName != NULL) {
+        /* events recorded from event device(struct input_event)   */
+        mReplayFp = (strcmp(replayName, "-") == 0) ? stdin : fopen(replayName, "rb");
+        if (mReplayFp == NULL)  {
+            perror(replayName);
             exit(9);
         }
     }
+    else    {
+        if (eventDeviceName == NULL) {
+            /* DEVICE of the panel, or default device   */
+            eventDeviceName = confDeviceName;
+        }
+        if (eventDeviceName == NULL) {
+            /* If event device not present, get default device  */
+            eventDeviceName = find_event_device();
+            if (eventDeviceName == NULL) {
+                /* System has no touchpanel, Error  */
+                exit(9);
+            }
+        }
 
-    evfd = open(eventDeviceName, O_RDONLY);
-    if (evfd < 0) {
-        perror("Open event device");
-        exit(9);
+        mEvfd = open(eventDeviceName, O_RDONLY | O_NONBLOCK);
+        if (mEvfd < 0) {
+            perror("Open event device");
+            exit(9);
+        }
+        /* wait for touches without polling     */
+        mEpfd = epoll_create1(EPOLL_CLOEXEC);
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.fd = mEvfd;
+        if ((mEpfd < 0) || (epoll_ctl(mEpfd, EPOLL_CTL_ADD, mEvfd, &ev) < 0))  {
+            perror("epoll event device");
+            close(mEvfd);
+            exit(9);
+        }
+        /* touch at the same position reports no X/Y   */
+        get_position();
     }
 
-    /* Open configuration file for output   */
-    fp = open_conffile();
-    if (fp == NULL) {
+    /* Check configuration file for output(other lines are kept), not opened,   */
+    /* because the running daemon reloads when the file is written             */
+    if (! conf_writable())  {
+        perror(conf_path());
         fprintf(stderr, "%s: Can not open config file\n", argv[0]);
-        close(evfd);
         exit(8);
     }
 
@@ -122,46 +265,50 @@ main(int argc, char *argv[])
     CALIBRATION_PRINT("+================================================+\n");
     CALIBRATION_PRINT("| Configration Tool for Calibration Touch ver0.1 |\n");
     CALIBRATION_PRINT("+------------------------------------------------+\n");
-    CALIBRATION_PRINT("| use display width = %d\n", CALIBRATION_DISP_WIDTH);
-    CALIBRATION_PRINT("| use display height = %d\n", CALIBRATION_DISP_HEIGHT);
+    CALIBRATION_PRINT("| use display width = %d\n", mDispWidth);
+    CALIBRATION_PRINT("| use display height = %d\n", mDispHeight);
+    CALIBRATION_PRINT("| use calibration points = %d\n", mPoints);
+    if (replayName != NULL) {
+        CALIBRATION_PRINT("| use recorded events = %s\n", replayName);
+    }
     CALIBRATION_PRINT("+------------------------------------------------+\n");
 
-    get_coordinates(evfd);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (mPoints == 4)   {
+        get_coordinates();
+    }
+    else if (get_points() < 0)  {
+        CALIBRATION_PRINT("| points can not determine calibration          |\n");
+        exit(8);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    CALIBRATION_PRINT("| calibration time = %.1f sec\n",
+                      (double)(end.tv_sec - start.tv_sec) +
+                      (double)(end.tv_nsec - start.tv_nsec) / 1000000000.0);
+    CALIBRATION_PRINT("| fit time = %d usec\n", mFitUsec);
 
     CALIBRATION_PRINT("+------------------------------------------------+\n");
     CALIBRATION_PRINT("| save config                                    |\n");
     CALIBRATION_PRINT("+------------------------------------------------+\n");
 
-    cnt = sprintf(buff, "%s=%d\n", CALIBRATOIN_STR_DISP_W, mDispWidth);
-    fwrite(buff, sizeof(char), cnt, fp);
-    CALIBRATION_PRINT("| %s", buff);
-
-    cnt = sprintf(buff, "%s=%d\n", CALIBRATOIN_STR_DISP_H, mDispHeight);
-    fwrite(buff, sizeof(char), cnt, fp);
-    CALIBRATION_PRINT("| %s", buff);
-
-    cnt = sprintf(buff, "%s=%d*%d\n", CALIBRATOIN_STR_POS1, mPosX[0], mPosY[0]);
-    fwrite(buff, sizeof(char), cnt, fp);
-    CALIBRATION_PRINT("| %s", buff);
-
-    cnt = sprintf(buff, "%s=%d*%d\n", CALIBRATOIN_STR_POS2, mPosX[1], mPosY[1]);
-    fwrite(buff, sizeof(char), cnt, fp);
-    CALIBRATION_PRINT("| %s", buff);
-
-    cnt = sprintf(buff, "%s=%d*%d\n", CALIBRATOIN_STR_POS3, mPosX[2], mPosY[2]);
-    fwrite(buff, sizeof(char), cnt, fp);
-    CALIBRATION_PRINT("| %s", buff);
-
-    cnt = sprintf(buff, "%s=%d*%d\n", CALIBRATOIN_STR_POS4, mPosX[3], mPosY[3]);
-    fwrite(buff, sizeof(char), cnt, fp);
-    CALIBRATION_PRINT("| %s", buff);
-
-    if (evfd >= 0) {
-        close(evfd);
+    if (mEpfd >= 0) {
+        close(mEpfd);
+    }
+    if (mEvfd >= 0) {
+        close(mEvfd);
+    }
+    if ((mReplayFp != NULL) && (mReplayFp != stdin))    {
+        fclose(mReplayFp);
     }
 
-    /* Close outputed configuration file    */
-    fclose(fp);
+    if (write_conffile(npanel) < 0) {
+        fprintf(stderr, "%s: Can not write config file\n", argv[0]);
+        exit(8);
+    }
+    if ((reportName != NULL) && (write_report(reportName) < 0)) {
+        fprintf(stderr, "%s: Can not write report file\n", argv[0]);
+        exit(8);
+    }
 
     CALIBRATION_PRINT("|                                                |\n");
     CALIBRATION_PRINT("| finish Tools                                   |\n");
@@ -239,72 +386,292 @@ find_event_device(void)
 /**
  * @brief       read coordinates form touchpanel
  *
- * @param[in]   evfd        touchpanel event device
+ * @param       nothing
  * @return      nothing
  */
 /*--------------------------------------------------------------------------*/
 static void
-get_coordinates(int evfd)
+get_coordinates(void)
 {
-    int     bufX[CALIBCONF_READ_NUM];
-    int     bufY[CALIBCONF_READ_NUM];
-    int     x, y;
+    static const char   *corner[4] = {
+        "Top-Left", "Top-Right", "Bottom-Left", "Bottom-Right" };
+    int     bufX[CALIBRATOIN_TOUCH_MAX];
+    int     bufY[CALIBRATOIN_TOUCH_MAX];
+    int     dispX[4];
+    int     dispY[4];
+    int     first;
+    int     num;
     int     ii;
+    struct timespec start, end;
 
-    CALIBRATION_PRINT("| Touch the Top-Left corner of the screen %d times\n",
-                      CALIBCONF_READ_NUM);
-    for (ii = 0; ii < CALIBCONF_READ_NUM; ii++) {
-        read_event(evfd, &x, &y);
-        bufX[ii] = x;
-        bufY[ii] = y;
-        CALIBRATION_PRINT("| # %d: %dx%d \n", ii, x, y);
+    for (ii = 0; ii < 4; ii++)  {
+        if (ii > 0) {
+            CALIBRATION_PRINT("+------------------------------------------------+\n");
+        }
+        CALIBRATION_PRINT("| Touch the %s corner of the screen %d-%d times\n",
+                          corner[ii], CALIBRATOIN_TOUCH_MIN, CALIBRATOIN_TOUCH_MAX);
+        /* corners of screen(same as daemon)    */
+        calibration_point(4, ii, mDispWidth, mDispHeight, &dispX[ii], &dispY[ii]);
+        first = mNumTouch;
+        num = read_point(dispX[ii], dispY[ii]);
+        mCount[ii] = num;
+        memcpy(bufX, &mRawX[first], sizeof(int) * num);
+        memcpy(bufY, &mRawY[first], sizeof(int) * num);
+        sort_data(bufX, 0, num - 1);
+        sort_data(bufY, 0, num - 1);
+        mPosX[ii] = delta_add(bufX[num / 2]);
+        mPosY[ii] = delta_add(bufY[num / 2]);
     }
-    sort_data(bufX, 0, CALIBCONF_READ_NUM - 1);
-    sort_data(bufY, 0, CALIBCONF_READ_NUM - 1);
-    mPosX[0] = delta_add(bufX[CALIBCONF_READ_NUM / 2]);
-    mPosY[0] = delta_add(bufY[CALIBCONF_READ_NUM / 2]);
 
-    CALIBRATION_PRINT("+------------------------------------------------+\n");
-    CALIBRATION_PRINT("| Touch the Top-Right corner of the screen %d times\n",
-                      CALIBCONF_READ_NUM);
-    for (ii = 0; ii < CALIBCONF_READ_NUM; ii++) {
-        read_event(evfd, &x, &y);
-        bufX[ii] = x;
-        bufY[ii] = y;
-        CALIBRATION_PRINT("| # %d: %dx%d \n", ii, x, y);
-    }
-    sort_data(bufX, 0, CALIBCONF_READ_NUM - 1);
-    sort_data(bufY, 0, CALIBCONF_READ_NUM - 1);
-    mPosX[1] = delta_add(bufX[CALIBCONF_READ_NUM / 2]);
-    mPosY[1] = delta_add(bufY[CALIBCONF_READ_NUM / 2]);
+    /* transform of daemon for residual of touches  */
+    for (ii = 0; ii < mNumTouch; ii++)  {
+        mInlier[ii] = 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (calibration_fit(&mMatrix, mPosX, mPosY, dispX, dispY, 4,
+                        mDispWidth, mDispHeight) == 0)  {
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        mFitUsec = (int)((end.tv_sec - start.tv_sec) * 1000000 +
+                         (end.tv_nsec - start.tv_nsec) / 1000);
+        mFitted = 1;
+        fit_residuals();
+        report_points();
+    }
+}
 
-    CALIBRATION_PRINT("+------------------------------------------------+\n");
-    CALIBRATION_PRINT("| Touch the Bottom-Left corner of the screen %d times\n",
-                      CALIBCONF_READ_NUM);
-    for (ii = 0; ii < CALIBCONF_READ_NUM; ii++) {
-        read_event(evfd, &x, &y);
-        bufX[ii] = x;
-        bufY[ii] = y;
-        CALIBRATION_PRINT("| # %d: %dx%d \n", ii, x, y);
-    }
-    sort_data(bufX, 0, CALIBCONF_READ_NUM - 1);
-    sort_data(bufY, 0, CALIBCONF_READ_NUM - 1);
-    mPosX[2] = delta_add(bufX[CALIBCONF_READ_NUM / 2]);
-    mPosY[2] = delta_add(bufY[CALIBCONF_READ_NUM / 2]);
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       read touches of a point until the point is stable
+ *
+ * @param[in]   dispx       X coordinate of screen
+ * @param[in]   dispy       Y coordinate of screen
+ * @return      number of touches
+ */
+/*--------------------------------------------------------------------------*/
+static int
+read_point(int dispx, int dispy)
+{
+    int     *bufX = &mRawX[mNumTouch];
+    int     *bufY = &mRawY[mNumTouch];
+    int     num;
+
+    for (num = 0; num < CALIBRATOIN_TOUCH_MAX; )    {
+        read_event(&bufX[num], &bufY[num]);
+        CALIBRATION_PRINT("| # %d: %dx%d \n", num, bufX[num], bufY[num]);
+        mTouchX[mNumTouch + num] = dispx;
+        mTouchY[mNumTouch + num] = dispy;
+        num ++;
+        if ((num >= CALIBRATOIN_TOUCH_MIN) &&
+            calibration_stable(bufX, num, CALIBRATOIN_TOUCH_CONVERGE) &&
+            calibration_stable(bufY, num, CALIBRATOIN_TOUCH_CONVERGE))  {
+            break;
+        }
+    }
+    mNumTouch += num;
+    return num;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       read coordinates of N-point grid from touchpanel and fit
+ *              transform by least squares, touches far from the fit are
+ *              rejected(MAD) instead of taking median of each point
+ *
+ * @param       nothing
+ * @return      result
+ * @retval      0           sucess
+ * @retval      -1          points can not determine transform
+ */
+/*--------------------------------------------------------------------------*/
+static int
+get_points(void)
+{
+    int     tx, ty;
+    int     ii;
+    struct timespec start, end;
+
+    for (ii = 0; ii < mPoints; ii++)    {
+        calibration_point(mPoints, ii, mDispWidth, mDispHeight, &tx, &ty);
+        if (ii > 0) {
+            CALIBRATION_PRINT("+------------------------------------------------+\n");
+        }
+        CALIBRATION_PRINT("| Touch the point %d/%d at %dx%d of the screen %d-%d times\n",
+                          ii + 1, mPoints, tx, ty, CALIBRATOIN_TOUCH_MIN, CALIBRATOIN_TOUCH_MAX);
+        mCount[ii] = read_point(tx, ty);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (calibration_fit_robust(&mMatrix, mRawX, mRawY, mTouchX, mTouchY, mNumTouch,
+                               mDispWidth, mDispHeight, mInlier) < 0) {
+        return -1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    mFitUsec = (int)((end.tv_sec - start.tv_sec) * 1000000 +
+                     (end.tv_nsec - start.tv_nsec) / 1000);
+    mFitted = 1;
+    fit_residuals();
+    report_points();
+    matrix_positions();
+    return 0;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       residual of each point(mean of used touches), and mean and
+ *              max of all used touches
+ *
+ * @param       nothing
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+static void
+fit_residuals(void)
+{
+    double  ex, ey;
+    double  sumx, sumy;
+    double  absx = 0.0, absy = 0.0;
+    int     nused = 0;
+    int     num = 0;
+    int     ii, jj;
+
+    mMaxX = 0.0;
+    mMaxY = 0.0;
+    for (ii = 0; ii < mPoints; ii++)    {
+        sumx = 0.0;
+        sumy = 0.0;
+        mResult[ii].used = 0;
+        for (jj = num; jj < (num + mCount[ii]); jj++)   {
+            if (! mInlier[jj])  continue;
+            calibration_residual(&mMatrix, mRawX[jj], mRawY[jj], mTouchX[jj], mTouchY[jj],
+                                 &ex, &ey);
+            sumx += ex;
+            sumy += ey;
+            mResult[ii].used ++;
+            if (ex < 0.0)   ex = -ex;
+            if (ey < 0.0)   ey = -ey;
+            absx += ex;
+            absy += ey;
+            if (ex > mMaxX) mMaxX = ex;
+            if (ey > mMaxY) mMaxY = ey;
+        }
+        mResult[ii].dx = (mResult[ii].used > 0) ? (sumx / mResult[ii].used) : 0.0;
+        mResult[ii].dy = (mResult[ii].used > 0) ? (sumy / mResult[ii].used) : 0.0;
+        nused += mResult[ii].used;
+        num += mCount[ii];
+    }
+    mMeanX = (nused > 0) ? (absx / nused) : 0.0;
+    mMeanY = (nused > 0) ? (absy / nused) : 0.0;
+    mRejected = mNumTouch - nused;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       print residual of each point and rejected touches
+ *
+ * @param       nothing
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+static void
+report_points(void)
+{
+    int     num = 0;
+    int     ii;
 
     CALIBRATION_PRINT("+------------------------------------------------+\n");
-    CALIBRATION_PRINT("| Touch the Bottom-Right corner of the screen %d times\n",
-                      CALIBCONF_READ_NUM);
-    for (ii = 0; ii < CALIBCONF_READ_NUM; ii++) {
-        read_event(evfd, &x, &y);
-        bufX[ii] = x;
-        bufY[ii] = y;
-        CALIBRATION_PRINT("| # %d: %dx%d \n", ii, x, y);
-    }
-    sort_data(bufX, 0, CALIBCONF_READ_NUM - 1);
-    sort_data(bufY, 0, CALIBCONF_READ_NUM - 1);
-    mPosX[3] = delta_add(bufX[CALIBCONF_READ_NUM / 2]);
-    mPosY[3] = delta_add(bufY[CALIBCONF_READ_NUM / 2]);
+    CALIBRATION_PRINT("| residual of points(pixel)                      |\n");
+    for (ii = 0; ii < mPoints; ii++)    {
+        CALIBRATION_PRINT("| %2d: %4dx%-4d used %d/%d dx=%+6.2f dy=%+6.2f\n",
+                          ii + 1, mTouchX[num], mTouchY[num], mResult[ii].used,
+                          mCount[ii], mResult[ii].dx, mResult[ii].dy);
+        num += mCount[ii];
+    }
+    CALIBRATION_PRINT("| mean |dx|=%.2f |dy|=%.2f, max |dx|=%.2f |dy|=%.2f\n",
+                      mMeanX, mMeanY, mMaxX, mMaxY);
+    CALIBRATION_PRINT("| rejected touches = %d/%d\n", mRejected, mNumTouch);
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       write fit report(KEY=value lines, same format as config file)
+ *
+ * @param[in]   path        report file
+ * @return      result
+ * @retval      0           sucess
+ * @retval      -1          write error
+ */
+/*--------------------------------------------------------------------------*/
+static int
+write_report(const char *path)
+{
+    FILE    *fp;
+    int     num = 0;
+    int     ii;
+
+    fp = fopen(path, "w");
+    if (fp == NULL) {
+        perror(path);
+        return -1;
+    }
+    fprintf(fp, "POINTS=%d\n", mPoints);
+    fprintf(fp, "TOUCHES=%d\n", mNumTouch);
+    fprintf(fp, "FITTED=%d\n", mFitted);
+    if (mFitted)    {
+        fprintf(fp, "REJECTED=%d\n", mRejected);
+        fprintf(fp, "MEAN_DX=%.3f\n", mMeanX);
+        fprintf(fp, "MEAN_DY=%.3f\n", mMeanY);
+        fprintf(fp, "MAX_DX=%.3f\n", mMaxX);
+        fprintf(fp, "MAX_DY=%.3f\n", mMaxY);
+        fprintf(fp, "%s=%d*%d*%d*%d*%d*%d\n", CALIBRATOIN_STR_MATRIX,
+                mMatrix.a, mMatrix.b, mMatrix.c, mMatrix.d, mMatrix.e, mMatrix.f);
+    }
+    /* time of touches(event time, same for same recorded events)  */
+    fprintf(fp, "TOUCH_TIME=%.3f\n", (double)(mLastUsec - mFirstUsec) / 1000000.0);
+    for (ii = 0; ii < mPoints; ii++)    {
+        /* X*Y of screen, used touches, touches, mean residual of X and Y   */
+        fprintf(fp, "POINT%d=%d*%d*%d*%d*%.3f*%.3f\n", ii + 1,
+                mTouchX[num], mTouchY[num], mResult[ii].used, mCount[ii],
+                mResult[ii].dx, mResult[ii].dy);
+        num += mCount[ii];
+    }
+
+    if (fclose(fp) != 0)    {
+        perror(path);
+        return -1;
+    }
+    return 0;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       touchpanel coordinates of screen corners by inverse transform
+ *              (POSITION1-4 for daemon without MATRIX)
+ *
+ * @param       nothing
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+static void
+matrix_positions(void)
+{
+    double  det;
+    double  sx, sy;
+    double  x, y;
+    int     ii;
+
+    det = (double)mMatrix.a * mMatrix.e - (double)mMatrix.b * mMatrix.d;
+    if (det == 0.0) {
+        return;
+    }
+    for (ii = 0; ii < 4; ii++)  {
+        /* 0:Top-Left, 1:Top-Right, 2:Bottom-Left, 3:Bottom-Right   */
+        sx = (double)((ii & 1) ? mDispWidth : 0) * (1 << CALIBRATOIN_MATRIX_SHIFT) - mMatrix.c;
+        sy = (double)((ii & 2) ? mDispHeight : 0) * (1 << CALIBRATOIN_MATRIX_SHIFT) - mMatrix.f;
+        x = (mMatrix.e * sx - mMatrix.b * sy) / det;
+        y = (mMatrix.a * sy - mMatrix.d * sx) / det;
+        mPosX[ii] = (int)((x >= 0.0) ? (x + 0.5) : (x - 0.5));
+        mPosY[ii] = (int)((y >= 0.0) ? (y + 0.5) : (y - 0.5));
+    }
 }
 
 /*--------------------------------------------------------------------------*/
@@ -354,106 +721,470 @@ sort_data(int buff[], int left, int right)
 
 /*--------------------------------------------------------------------------*/
 /**
- * @brief       event read from touchpanel
+ * @brief       get an event from touchpanel or recorded events
+ *              quiet time of recorded events is judged by time of events
  *
- * @param[in]   evfd        touchpanel event device
+ * @param[out]  event       event
+ * @param[in]   timeout     wait time(ms, -1: no timeout)
+ * @return      result
+ * @retval      1           event
+ * @retval      0           no event in timeout
+ */
+/*--------------------------------------------------------------------------*/
+static int
+get_event(struct input_event *event, int timeout)
+{
+    struct epoll_event  ev;
+    unsigned long long  usec;
+    int                 rsize;
+    int                 ret;
+
+    while (mEventPos >= mEventNum)  {
+        if (mReplayFp != NULL)  {
+            if (! mEventEnd)    {
+                mEventNum = fread(mEvents, sizeof(struct input_event),
+                                  CALIBCONF_EVENT_NUM, mReplayFp);
+                mEventPos = 0;
+                if (mEventNum > 0)  continue;
+                mEventEnd = 1;
+            }
+            if (timeout >= 0)   {
+                /* end of recorded events is quiet      */
+                return 0;
+            }
+            CALIBRATION_PRINT("| recorded events end before calibration\n");
+            exit(9);
+        }
+        /* wait for event   */
+        ret = epoll_wait(mEpfd, &ev, 1, timeout);
+        if (ret == 0)   {
+            return 0;
+        }
+        else if (ret < 0)   {
+            continue;
+        }
+        rsize = read(mEvfd, mEvents, sizeof(mEvents));
+        if (rsize > 0)  {
+            mEventNum = rsize / sizeof(struct input_event);
+            mEventPos = 0;
+            continue;
+        }
+        if ((rsize < 0) && ((errno == EAGAIN) || (errno == EINTR)))   {
+            continue;
+        }
+        /* touchpanel is disconnected   */
+        perror("Read event device");
+        exit(9);
+    }
+
+    usec = (unsigned long long)mEvents[mEventPos].time.tv_sec * 1000000ULL +
+           (unsigned long long)mEvents[mEventPos].time.tv_usec;
+    if ((mReplayFp != NULL) && (timeout >= 0) && (mLastUsec != 0) &&
+        (usec > (mLastUsec + (unsigned long long)timeout * 1000ULL)))  {
+        /* next event is after quiet time   */
+        return 0;
+    }
+    *event = mEvents[mEventPos ++];
+    if (mFirstUsec == 0)    {
+        mFirstUsec = usec;
+    }
+    mLastUsec = usec;
+    return 1;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       get current position of touchpanel(event device)
+ *
+ * @param       nothing
  * @return      nothing
  */
 /*--------------------------------------------------------------------------*/
 static void
-read_event(int evfd, int *x, int *y)
+get_position(void)
+{
+    struct input_absinfo absinfo;
+
+    if (ioctl(mEvfd, EVIOCGABS(ABS_X), &absinfo) >= 0)   {
+        mLastX = absinfo.value;
+    }
+    if (ioctl(mEvfd, EVIOCGABS(ABS_Y), &absinfo) >= 0)   {
+        mLastY = absinfo.value;
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       event read from touchpanel(a touch)
+ *              a touch ends at release of BTN_TOUCH, or at quiet time for
+ *              touchpanel without BTN_TOUCH, X/Y same as the last value is
+ *              not reported by kernel, so the touch is at the last X/Y
+ *
+ * @param[out]  x           X coordinate of touch
+ * @param[out]  y           Y coordinate of touch
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+static void
+read_event(int *x, int *y)
 {
-    fd_set      fds;
-    int         ret;
-    int         rsize;
-    int         ii;
     int         flagX = 0;
     int         flagY = 0;
-    struct timeval  delay;
-    struct input_event events[64];
+    int         button = 0;
+    int         press = 0;
+    int         release = 0;
+    struct input_event event;
 
     while (1) {
-        /* select timeoutt value    */
-        delay.tv_sec = 0;
-        delay.tv_usec = 100*1000;
-        /* fs_set                   */
-        FD_ZERO(&fds);
-        FD_SET(evfd, &fds);
-
-        /* wait for event read or timedout  */
-        ret = select(evfd + 1, &fds, NULL, NULL, &delay);
-        if (ret <= 0) {
-            continue;
+        /* wait for event(no timeout)   */
+        get_event(&event, -1);
+        if ((event.type == EV_ABS) && (event.code == ABS_X)) {
+            /* X       */
+            flagX++;
+            mLastX = event.value;
         }
-        if (FD_ISSET(evfd, &fds)) {
-            /* event read           */
-            rsize = read(evfd, events, sizeof(events) );
-            for (ii = 0; ii < (int)(rsize/sizeof(struct input_event)); ii++) {
-                if ((events[ii].type == EV_ABS) && (events[ii].code == ABS_X)) {
-                    /* X       */
-                    flagX++;
-                    *x = events[ii].value;
-                }
-                else if ((events[ii].type == EV_ABS) && (events[ii].code == ABS_Y)) {
-                    /* Y       */
-                    flagY++;
-                    *y = events[ii].value;
-                }
+        else if ((event.type == EV_ABS) && (event.code == ABS_Y)) {
+            /* Y       */
+            flagY++;
+            mLastY = event.value;
+        }
+        else if ((event.type == EV_KEY) &&
+                 ((event.code == BTN_TOUCH) || (event.code == BTN_LEFT))) {
+            /* touch on/off */
+            button = 1;
+            if (event.value == 0)   {
+                release = 1;
+            }
+            else    {
+                press = 1;
             }
         }
-        /* Input 2 times (Touch On and Off) */
-        if ((flagX >= 2) && (flagY >= 2)) {
-            break;
+        else if ((event.type == EV_SYN) && (event.code == SYN_REPORT)) {
+            if (release)    {
+                /* release of this touch, or of previous touch  */
+                if ((press) && (mLastX >= 0) && (mLastY >= 0)) break;
+                if (press)  {
+                    CALIBRATION_PRINT("| position of touch is unknown, touch again\n");
+                }
+                /* next touch starts with no state  */
+                flagX = 0;
+                flagY = 0;
+                press = 0;
+                release = 0;
+            }
+            else if ((! button) && (flagX >= 2) && (flagY >= 2)) {
+                /* Input 2 times (Touch On and Off) */
+                break;
+            }
         }
     }
+    *x = mLastX;
+    *y = mLastY;
 
-    while (1) {
-        delay.tv_sec = 0;
-        delay.tv_usec = 200*1000;
-        FD_ZERO(&fds);
-        FD_SET(evfd, &fds);
-
-        /* wait for input (or timedout) */
-        ret = select(evfd + 1, &fds, NULL, NULL, &delay);
-        if (ret == 0) {
-            break;
-        }
-        else if (ret < 0) {
-            continue;
-        }
-        rsize = read(evfd, events, sizeof(events));
+    if (button) {
+        /* discard rest of the touch    */
+        while (get_event(&event, 0))    ;
+        return;
     }
+    /* wait for end of input(quiet time)    */
+    while (get_event(&event, CALIBCONF_QUIET_MS))   ;
 }
 
 /*--------------------------------------------------------------------------*/
 /**
- * @brief       open configuration file
+ * @brief       path of configuration file
  *
  * @param       nothing
- * @return      file descriptor
- * @retval      != NULL     file descriptor
- * @retval      NULL        open error
+ * @return      path
  */
 /*--------------------------------------------------------------------------*/
-static FILE *
-open_conffile(void)
+static const char *
+conf_path(void)
 {
     char    *confp;
-    FILE    *fp;
 
     /* Get configuration file path  */
     confp = getenv(CALIBRATOIN_CONF_ENV);
     if (! confp)  {
         confp = CALIBRATOIN_CONF_FILE;
     }
+    return confp;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       check that configuration file can be written(temporary file
+ *              in the same directory is renamed to the file)
+ *
+ * @param       nothing
+ * @return      result
+ * @retval      1           writable
+ * @retval      0           not writable(errno is set)
+ */
+/*--------------------------------------------------------------------------*/
+static int
+conf_writable(void)
+{
+    const char  *confp;
+    const char  *name;
+    char    dir[CALIBRATOIN_CONF_LEN_MAX];
+
+    confp = conf_path();
+    name = strrchr(confp, '/');
+    if (name == NULL)   {
+        strcpy(dir, ".");
+    }
+    else if (name == confp) {
+        strcpy(dir, "/");
+    }
+    else    {
+        snprintf(dir, sizeof(dir), "%.*s", (int)(name - confp), confp);
+    }
+    return (access(dir, W_OK) == 0) ? 1 : 0;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       check key of a touchpanel(counted same as daemon for
+ *              [PANEL] sections)
+ *
+ * @param[in]   line        line of configuration file
+ * @return      result
+ * @retval      1           key of a touchpanel
+ * @retval      0           other line
+ */
+/*--------------------------------------------------------------------------*/
+static int
+conf_panel_key(const char *line)
+{
+    if ((strncmp(line, CALIBRATOIN_STR_DEVICE, sizeof(CALIBRATOIN_STR_DEVICE) - 1) == 0) ||
+        (strncmp(line, CALIBRATOIN_STR_REGION, sizeof(CALIBRATOIN_STR_REGION) - 1) == 0))  {
+        return 1;
+    }
+    return conf_calib_key(line);
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       check key written by this tool
+ *
+ * @param[in]   line        line of configuration file
+ * @return      result
+ * @retval      1           key of calibration(replaced)
+ * @retval      0           other line(kept)
+ */
+/*--------------------------------------------------------------------------*/
+static int
+conf_calib_key(const char *line)
+{
+    if ((strncmp(line, CALIBRATOIN_STR_DISP_W, sizeof(CALIBRATOIN_STR_DISP_W) - 1) == 0) ||
+        (strncmp(line, CALIBRATOIN_STR_DISP_H, sizeof(CALIBRATOIN_STR_DISP_H) - 1) == 0) ||
+        (strncmp(line, CALIBRATOIN_STR_POS1, sizeof(CALIBRATOIN_STR_POS1) - 1) == 0) ||
+        (strncmp(line, CALIBRATOIN_STR_POS2, sizeof(CALIBRATOIN_STR_POS2) - 1) == 0) ||
+        (strncmp(line, CALIBRATOIN_STR_POS3, sizeof(CALIBRATOIN_STR_POS3) - 1) == 0) ||
+        (strncmp(line, CALIBRATOIN_STR_POS4, sizeof(CALIBRATOIN_STR_POS4) - 1) == 0) ||
+        (strncmp(line, CALIBRATOIN_STR_MATRIX, sizeof(CALIBRATOIN_STR_MATRIX) - 1) == 0))  {
+        return 1;
+    }
+    return 0;
+}
 
-    /* Open configuration file      */
-    fp = fopen(confp, "w");
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       event device(DEVICE) of a touchpanel in configuration file
+ *
+ * @param[in]   npanel      panel number
+ * @param[out]  nsect       number of panels in configuration file
+ * @return      device name
+ * @retval      != NULL     device name string
+ * @retval      == NULL     panel has no DEVICE
+ */
+/*--------------------------------------------------------------------------*/
+static char *
+conf_panel_device(int npanel, int *nsect)
+{
+    FILE    *fp;
+    char    buff[CALIBRATOIN_CONF_LEN_MAX];
+    char    *value;
+    int     sect = 0;
+    int     nkey = 0;
+    static char edevice[CALIBRATOIN_CONF_LEN_MAX];
+
+    *nsect = 1;
+    fp = fopen(conf_path(), "r");
     if (fp == NULL) {
+        return NULL;
+    }
+    edevice[0] = 0;
+    while (fgets(buff, sizeof(buff), fp))   {
+        if (buff[0] == '#') {
+            continue;
+        }
+        if (strncmp(buff, CALIBRATOIN_STR_PANEL, sizeof(CALIBRATOIN_STR_PANEL) - 1) == 0)  {
+            if (nkey > 0)   {
+                sect ++;
+                nkey = 0;
+            }
+            continue;
+        }
+        if (! conf_panel_key(buff)) {
+            continue;
+        }
+        nkey ++;
+        if ((sect == npanel) &&
+            (strncmp(buff, CALIBRATOIN_STR_DEVICE, sizeof(CALIBRATOIN_STR_DEVICE) - 1) == 0)) {
+            strtok(buff, CALIBRATOIN_STR_SEPAR);
+            value = strtok(NULL, CALIBRATOIN_STR_SEPAR " \t\r\n");
+            if (value)  {
+                strncpy(edevice, value, sizeof(edevice) - 1);
+            }
+        }
+    }
+    fclose(fp);
+    *nsect = sect + 1;
+
+    if (edevice[0] == 0)    {
+        return NULL;
+    }
+    CALIBRATION_INFO("Event device of panel %d=<%s>\n", npanel, edevice);
+    return edevice;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       write calibration keys
+ *
+ * @param[in]   fp          configuration file
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+static void
+conf_write_keys(FILE *fp)
+{
+    char    buff[CALIBRATOIN_CONF_LEN_MAX];
+
+    snprintf(buff, sizeof(buff), "%s=%d\n", CALIBRATOIN_STR_DISP_W, mDispWidth);
+    fputs(buff, fp);
+    CALIBRATION_PRINT("| %s", buff);
+
+    snprintf(buff, sizeof(buff), "%s=%d\n", CALIBRATOIN_STR_DISP_H, mDispHeight);
+    fputs(buff, fp);
+    CALIBRATION_PRINT("| %s", buff);
+
+    snprintf(buff, sizeof(buff), "%s=%d*%d\n", CALIBRATOIN_STR_POS1, mPosX[0], mPosY[0]);
+    fputs(buff, fp);
+    CALIBRATION_PRINT("| %s", buff);
+
+    snprintf(buff, sizeof(buff), "%s=%d*%d\n", CALIBRATOIN_STR_POS2, mPosX[1], mPosY[1]);
+    fputs(buff, fp);
+    CALIBRATION_PRINT("| %s", buff);
+
+    snprintf(buff, sizeof(buff), "%s=%d*%d\n", CALIBRATOIN_STR_POS3, mPosX[2], mPosY[2]);
+    fputs(buff, fp);
+    CALIBRATION_PRINT("| %s", buff);
+
+    snprintf(buff, sizeof(buff), "%s=%d*%d\n", CALIBRATOIN_STR_POS4, mPosX[3], mPosY[3]);
+    fputs(buff, fp);
+    CALIBRATION_PRINT("| %s", buff);
+
+    if (mPoints != 4)   {
+        /* transform of N-point, used by daemon instead of positions */
+        snprintf(buff, sizeof(buff), "%s=%d*%d*%d*%d*%d*%d\n", CALIBRATOIN_STR_MATRIX,
+                 mMatrix.a, mMatrix.b, mMatrix.c, mMatrix.d, mMatrix.e, mMatrix.f);
+        fputs(buff, fp);
+        CALIBRATION_PRINT("| %s", buff);
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       write configuration file
+ *              calibration keys of the panel are replaced, and other lines
+ *              (filter, other panels and comments) are kept
+ *
+ * @param[in]   npanel      panel number
+ * @return      result
+ * @retval      0           sucess
+ * @retval      -1          write error, or no panel
+ */
+/*--------------------------------------------------------------------------*/
+static int
+write_conffile(int npanel)
+{
+    const char  *confp;
+    char    tmpp[CALIBRATOIN_CONF_LEN_MAX + 8];
+    char    buff[CALIBRATOIN_CONF_LEN_MAX];
+    FILE    *fin;
+    FILE    *fout;
+    int     sect = 0;
+    int     nkey = 0;
+    int     written = 0;
+    int     len;
+
+    confp = conf_path();
+    snprintf(tmpp, sizeof(tmpp), "%s.tmp", confp);
+    fout = fopen(tmpp, "w");
+    if (fout == NULL)   {
+        perror(tmpp);
+        return -1;
+    }
+    fin = fopen(confp, "r");
+    while ((fin != NULL) && fgets(buff, sizeof(buff), fin)) {
+        if (buff[0] != '#') {
+            if (strncmp(buff, CALIBRATOIN_STR_PANEL, sizeof(CALIBRATOIN_STR_PANEL) - 1) == 0)  {
+                if (nkey > 0)   {
+                    /* end of section   */
+                    if ((sect == npanel) && (! written))    {
+                        conf_write_keys(fout);
+                        written = 1;
+                    }
+                    sect ++;
+                    nkey = 0;
+                }
+            }
+            else if (conf_panel_key(buff))  {
+                nkey ++;
+                if ((sect == npanel) && conf_calib_key(buff))   {
+                    /* replaced at the first calibration key    */
+                    if (! written)  {
+                        conf_write_keys(fout);
+                        written = 1;
+                    }
+                    continue;
+                }
+            }
+        }
+        fputs(buff, fout);
+        len = strlen(buff);
+        if ((len > 0) && (buff[len - 1] != '\n') && feof(fin))  {
+            fputs("\n", fout);
+        }
+    }
+    if (fin != NULL)    {
+        fclose(fin);
+    }
+    if ((sect == npanel) && (! written))    {
+        conf_write_keys(fout);
+        written = 1;
+    }
+    if (fclose(fout) != 0)  {
+        perror(tmpp);
+        unlink(tmpp);
+        return -1;
+    }
+
+    if (! written)  {
+        CALIBRATION_PRINT("| panel %d is not in %s\n", npanel, confp);
+        unlink(tmpp);
+        return -1;
+    }
+    /* replace at once, daemon never reads a partial file */
+    if (rename(tmpp, confp) < 0)    {
         perror(confp);
-        return fp;
+        unlink(tmpp);
+        return -1;
     }
-    return fp;
+    return 0;
 }
 
 /*--------------------------------------------------------------------------*/
@@ -467,6 +1198,14 @@ open_conffile(void)
 static void
 print_usage(const char *pName)
 {
-    fprintf(stderr, "Usage: %s [-h][-width width][-height height] [device]\n", pName);
+    fprintf(stderr, "Usage: %s [-h][-width width][-height height][-points 4|9|16|25]"
+            "[-panel n][-replay file][-report file] [device]\n", pName);
+    fprintf(stderr, "       -points: 4 corners(default), or grid fitted by least squares\n");
+    fprintf(stderr, "       -panel: [PANEL] section of config file(0: first panel)\n");
+    fprintf(stderr, "       -replay: events recorded from event device(-: stdin)\n");
+    fprintf(stderr, "       -report: write fit report(KEY=value)\n");
+    fprintf(stderr, "       running ico_ictl-touch_egalax grabs the device, send SIGUSR2\n");
+    fprintf(stderr, "       to it before calibration, it grabs again with new calibration\n");
+    fprintf(stderr, "       when config file is written\n");
 }
 
@@ -0,0 +1,739 @@
+/*
+ * Copyright (c) 2013, TOYOTA MOTOR CORPORATION.
+ *
+ * This program is licensed under the terms and conditions of the
+ * Apache License, version 2.0.  The full text of the Apache License is at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ */
+/**
+ * @brief   Touchpanel(eGalax) affine calibration
+ *          fit of touchpanel to screen transform and its fixed-point apply,
+ *          jitter filter of coordinates,
+ *          shared by Device Input Controller and Calibration Tool
+ *
+ * @date    Oct-16-2026
+ */
+
+#include "ico_ictl-touch_egalax.h"
+
+static void calibration_apply_scale(const calibration_matrix *matrix, const int *x,
+                                    const int *y, int *outx, int *outy, int num);
+static void calibration_apply_swap(const calibration_matrix *matrix, const int *x,
+                                   const int *y, int *outx, int *outy, int num);
+static double calibration_filter_alpha(double cutoff, double period);
+static double calibration_median(double *value, int num);
+static void calibration_sort(int *value, int num);
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       solve 3x3 linear equation(Cramer's rule)
+ *
+ * @param[in]   m           coefficient matrix
+ * @param[in]   v           right side vector
+ * @param[out]  r           solution
+ * @return      result
+ * @retval      0           sucess
+ * @retval      -1          singular matrix
+ */
+/*--------------------------------------------------------------------------*/
+static int
+calibration_solve3(double m[3][3], const double v[3], double r[3])
+{
+    double  det;
+    double  scale;
+    int     ii, jj;
+
+    det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+        - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+        + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+
+    /* relative to magnitude of matrix, points on a line are singular   */
+    scale = 0.0;
+    for (ii = 0; ii < 3; ii++)  {
+        for (jj = 0; jj < 3; jj++)  {
+            if ((m[ii][jj] > scale) || (-m[ii][jj] > scale))    {
+                scale = (m[ii][jj] > 0) ? m[ii][jj] : -m[ii][jj];
+            }
+        }
+    }
+    if ((scale == 0.0) || ((det < 0 ? -det : det) < (scale * scale * scale * 1e-12)))  {
+        return -1;
+    }
+
+    r[0] = (v[0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+          - m[0][1] * (v[1] * m[2][2] - m[1][2] * v[2])
+          + m[0][2] * (v[1] * m[2][1] - m[1][1] * v[2])) / det;
+    r[1] = (m[0][0] * (v[1] * m[2][2] - m[1][2] * v[2])
+          - v[0] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+          + m[0][2] * (m[1][0] * v[2] - v[1] * m[2][0])) / det;
+    r[2] = (m[0][0] * (m[1][1] * v[2] - v[1] * m[2][1])
+          - m[0][1] * (m[1][0] * v[2] - v[1] * m[2][0])
+          + v[0] * (m[1][0] * m[2][1] - m[1][1] * m[2][0])) / det;
+    return 0;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       fit affine transform of touchpanel to screen(least squares)
+ *
+ * @param[out]  matrix      fixed-point transform
+ * @param[in]   rawx        X coordinate of touchpanel
+ * @param[in]   rawy        Y coordinate of touchpanel
+ * @param[in]   dispx       X coordinate of screen
+ * @param[in]   dispy       Y coordinate of screen
+ * @param[in]   num         number of points(3 or more)
+ * @param[in]   width       screen width
+ * @param[in]   height      screen height
+ * @return      result
+ * @retval      0           sucess
+ * @retval      -1          points can not determine transform
+ */
+/*--------------------------------------------------------------------------*/
+int
+calibration_fit(calibration_matrix *matrix, const int *rawx, const int *rawy,
+                const int *dispx, const int *dispy, int num, int width, int height)
+{
+    double  m[3][3];
+    double  vx[3], vy[3];
+    double  rx[3], ry[3];
+    double  x, y;
+    int     spanx, spany;
+    int     ii;
+
+    if ((num < 3) || (width <= 0) || (height <= 0)) {
+        return -1;
+    }
+
+    /* normal equation of [x y 1] * (a b c) = screen coordinate */
+    memset(m, 0, sizeof(m));
+    memset(vx, 0, sizeof(vx));
+    memset(vy, 0, sizeof(vy));
+    for (ii = 0; ii < num; ii++)    {
+        x = rawx[ii];
+        y = rawy[ii];
+        m[0][0] += x * x;
+        m[0][1] += x * y;
+        m[0][2] += x;
+        m[1][1] += y * y;
+        m[1][2] += y;
+        vx[0] += x * dispx[ii];
+        vx[1] += y * dispx[ii];
+        vx[2] += dispx[ii];
+        vy[0] += x * dispy[ii];
+        vy[1] += y * dispy[ii];
+        vy[2] += dispy[ii];
+    }
+    m[1][0] = m[0][1];
+    m[2][0] = m[0][2];
+    m[2][1] = m[1][2];
+    m[2][2] = num;
+
+    if ((calibration_solve3(m, vx, rx) != 0) ||
+        (calibration_solve3(m, vy, ry) != 0))   {
+        return -1;
+    }
+
+    /* cross term less than half pixel over the points is not skew  */
+    spanx = spany = 0;
+    for (ii = 1; ii < num; ii++)    {
+        if (abs(rawx[ii] - rawx[0]) > spanx)    spanx = abs(rawx[ii] - rawx[0]);
+        if (abs(rawy[ii] - rawy[0]) > spany)    spany = abs(rawy[ii] - rawy[0]);
+    }
+    if (((rx[1] < 0) ? -rx[1] : rx[1]) * spany < 0.5)  rx[1] = 0.0;
+    if (((ry[0] < 0) ? -ry[0] : ry[0]) * spanx < 0.5)  ry[0] = 0.0;
+
+#define TO_FIXED(v) \
+    ((int)((v) * (1 << CALIBRATOIN_MATRIX_SHIFT) + (((v) < 0) ? -0.5 : 0.5)))
+    matrix->a = TO_FIXED(rx[0]);
+    matrix->b = TO_FIXED(rx[1]);
+    matrix->c = TO_FIXED(rx[2]);
+    matrix->d = TO_FIXED(ry[0]);
+    matrix->e = TO_FIXED(ry[1]);
+    matrix->f = TO_FIXED(ry[2]);
+#undef  TO_FIXED
+    matrix->width = width;
+    matrix->height = height;
+    calibration_select(matrix);
+    return 0;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       fit affine transform with outlier rejection
+ *              points whose residual is far from the median by more than
+ *              CALIBRATOIN_FIT_MADK(3.5) * sigma(1.4826 * median absolute
+ *              deviation) are rejected, and the rest are fitted again
+ *              (X and Y are tested separately)
+ *
+ * @param[out]  matrix      fixed-point transform
+ * @param[in]   rawx        X coordinate of touchpanel
+ * @param[in]   rawy        Y coordinate of touchpanel
+ * @param[in]   dispx       X coordinate of screen
+ * @param[in]   dispy       Y coordinate of screen
+ * @param[in]   num         number of points(3 to CALIBRATOIN_FIT_NUM)
+ * @param[in]   width       screen width
+ * @param[in]   height      screen height
+ * @param[out]  inlier      result of each point(1: used, 0: rejected)
+ * @return      result
+ * @retval      >= 3        number of used points
+ * @retval      -1          points can not determine transform
+ */
+/*--------------------------------------------------------------------------*/
+int
+calibration_fit_robust(calibration_matrix *matrix, const int *rawx, const int *rawy,
+                       const int *dispx, const int *dispy, int num, int width,
+                       int height, int *inlier)
+{
+    int     fitrx[CALIBRATOIN_FIT_NUM], fitry[CALIBRATOIN_FIT_NUM];
+    int     fitdx[CALIBRATOIN_FIT_NUM], fitdy[CALIBRATOIN_FIT_NUM];
+    double  errx[CALIBRATOIN_FIT_NUM], erry[CALIBRATOIN_FIT_NUM];
+    double  dev[CALIBRATOIN_FIT_NUM];
+    int     keep[CALIBRATOIN_FIT_NUM];
+    double  medx, medy, limx, limy;
+    double  ex, ey;
+    int     nfit;
+    int     used;
+    int     changed;
+    int     iter;
+    int     ii;
+
+    if ((num < 3) || (num > CALIBRATOIN_FIT_NUM))   {
+        return -1;
+    }
+    for (ii = 0; ii < num; ii++)    {
+        inlier[ii] = 1;
+    }
+
+    for (iter = 0; ; iter++)    {
+        nfit = 0;
+        for (ii = 0; ii < num; ii++)    {
+            if (! inlier[ii])   continue;
+            fitrx[nfit] = rawx[ii];
+            fitry[nfit] = rawy[ii];
+            fitdx[nfit] = dispx[ii];
+            fitdy[nfit] = dispy[ii];
+            nfit ++;
+        }
+        if (calibration_fit(matrix, fitrx, fitry, fitdx, fitdy, nfit, width, height) != 0) {
+            return -1;
+        }
+        if (iter >= CALIBRATOIN_FIT_ITER)   {
+            break;
+        }
+
+        /* threshold is K * sigma(1.4826 * MAD) of residuals of all points,
+           MAD is not affected by outliers, and rejected points can return */
+        for (ii = 0; ii < num; ii++)    {
+            calibration_residual(matrix, rawx[ii], rawy[ii], dispx[ii], dispy[ii],
+                                 &errx[ii], &erry[ii]);
+        }
+        memcpy(dev, errx, sizeof(double) * num);
+        medx = calibration_median(dev, num);
+        memcpy(dev, erry, sizeof(double) * num);
+        medy = calibration_median(dev, num);
+        for (ii = 0; ii < num; ii++)    {
+            dev[ii] = (errx[ii] < medx) ? (medx - errx[ii]) : (errx[ii] - medx);
+        }
+        limx = CALIBRATOIN_FIT_MADK * 1.4826 * calibration_median(dev, num);
+        for (ii = 0; ii < num; ii++)    {
+            dev[ii] = (erry[ii] < medy) ? (medy - erry[ii]) : (erry[ii] - medy);
+        }
+        limy = CALIBRATOIN_FIT_MADK * 1.4826 * calibration_median(dev, num);
+        /* noise under a pixel is not an outlier    */
+        if (limx < CALIBRATOIN_FIT_MINERR)  limx = CALIBRATOIN_FIT_MINERR;
+        if (limy < CALIBRATOIN_FIT_MINERR)  limy = CALIBRATOIN_FIT_MINERR;
+
+        used = 0;
+        changed = 0;
+        for (ii = 0; ii < num; ii++)    {
+            ex = errx[ii] - medx;
+            ey = erry[ii] - medy;
+            keep[ii] = ((ex > limx) || (ex < -limx) || (ey > limy) || (ey < -limy)) ? 0 : 1;
+            used += keep[ii];
+            if (keep[ii] != inlier[ii]) changed ++;
+        }
+        if ((changed == 0) || (used < 3))   {
+            /* same points, or too few points to refit  */
+            break;
+        }
+        for (ii = 0; ii < num; ii++)    {
+            inlier[ii] = keep[ii];
+        }
+    }
+    return nfit;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       residual of a point(transformed position - screen position)
+ *              without rounding and clamp of fixed-point apply
+ *
+ * @param[in]   matrix      fixed-point transform
+ * @param[in]   x           X coordinate of touchpanel
+ * @param[in]   y           Y coordinate of touchpanel
+ * @param[in]   dispx       X coordinate of screen
+ * @param[in]   dispy       Y coordinate of screen
+ * @param[out]  errx        residual of X(pixel)
+ * @param[out]  erry        residual of Y(pixel)
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+void
+calibration_residual(const calibration_matrix *matrix, int x, int y,
+                     int dispx, int dispy, double *errx, double *erry)
+{
+    *errx = ((double)matrix->a * x + (double)matrix->b * y + matrix->c)
+            / (1 << CALIBRATOIN_MATRIX_SHIFT) - dispx;
+    *erry = ((double)matrix->d * x + (double)matrix->e * y + matrix->f)
+            / (1 << CALIBRATOIN_MATRIX_SHIFT) - dispy;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       check convergence of touches of a point, 95% interval of the
+ *              point(2 * sigma / sqrt(num), sigma = 1.4826 * MAD) is within
+ *              limit
+ *
+ * @param[in]   value       coordinates of touches(X or Y)
+ * @param[in]   num         number of touches(1 to CALIBRATOIN_TOUCH_MAX)
+ * @param[in]   limit       limit of interval(raw)
+ * @return      result
+ * @retval      1           stable
+ * @retval      0           more touches are needed
+ */
+/*--------------------------------------------------------------------------*/
+int
+calibration_stable(const int *value, int num, int limit)
+{
+    int     work[CALIBRATOIN_TOUCH_MAX];
+    int     median;
+    double  sigma;
+    int     ii;
+
+    if ((num <= 0) || (num > CALIBRATOIN_TOUCH_MAX))    {
+        return 0;
+    }
+    memcpy(work, value, sizeof(int) * num);
+    calibration_sort(work, num);
+    median = work[num / 2];
+    for (ii = 0; ii < num; ii++)    {
+        work[ii] = (value[ii] < median) ? (median - value[ii]) : (value[ii] - median);
+    }
+    calibration_sort(work, num);
+    sigma = 1.4826 * work[num / 2];
+
+    /* compare squares, no sqrt */
+    return ((4.0 * sigma * sigma) <= ((double)limit * limit * num)) ? 1 : 0;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       screen position of a calibration point, 4 corners of screen
+ *              or grid inside CALIBRATOIN_POINT_MARGIN
+ *
+ * @param[in]   npoint      number of points(4, 9, 16 or 25)
+ * @param[in]   index       point(0 to npoint - 1, from Top-Left by rows)
+ * @param[in]   width       screen width
+ * @param[in]   height      screen height
+ * @param[out]  x           X coordinate of screen
+ * @param[out]  y           Y coordinate of screen
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+void
+calibration_point(int npoint, int index, int width, int height, int *x, int *y)
+{
+    int     grid;
+    int     marginx, marginy;
+
+    if (npoint == 4)    {
+        /* corners of screen(POSITION1-4)   */
+        *x = (index & 1) ? width : 0;
+        *y = (index & 2) ? height : 0;
+        return;
+    }
+    grid = (npoint == 25) ? 5 : ((npoint == 16) ? 4 : 3);
+    marginx = width * CALIBRATOIN_POINT_MARGIN / 100;
+    marginy = height * CALIBRATOIN_POINT_MARGIN / 100;
+    *x = marginx + (width - 1 - marginx * 2) * (index % grid) / (grid - 1);
+    *y = marginy + (height - 1 - marginy * 2) * (index / grid) / (grid - 1);
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       sort integer values(insertion sort, values are few)
+ *
+ * @param[in,out] value     values
+ * @param[in]   num         number of values
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+static void
+calibration_sort(int *value, int num)
+{
+    int     tmp;
+    int     ii, jj;
+
+    for (ii = 1; ii < num; ii++)    {
+        tmp = value[ii];
+        for (jj = ii; (jj > 0) && (value[jj - 1] > tmp); jj--)  {
+            value[jj] = value[jj - 1];
+        }
+        value[jj] = tmp;
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       median of values(values are sorted)
+ *
+ * @param[in,out] value     values
+ * @param[in]   num         number of values(1 or more)
+ * @return      median
+ */
+/*--------------------------------------------------------------------------*/
+static double
+calibration_median(double *value, int num)
+{
+    double  tmp;
+    int     ii, jj;
+
+    /* insertion sort, points of calibration are few    */
+    for (ii = 1; ii < num; ii++)    {
+        tmp = value[ii];
+        for (jj = ii; (jj > 0) && (value[jj - 1] > tmp); jj--)  {
+            value[jj] = value[jj - 1];
+        }
+        value[jj] = tmp;
+    }
+    if (num & 1)    {
+        return value[num / 2];
+    }
+    return (value[num / 2 - 1] + value[num / 2]) / 2.0;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       compose rotation and mirror of screen into transform
+ *
+ * @param[in,out] matrix    fixed-point transform
+ * @param[in]   rotate      rotation(0, 90, 180 or 270, others are 0)
+ * @param[in]   mirrorx     mirror X coordinate after rotation(0 or 1)
+ * @param[in]   mirrory     mirror Y coordinate after rotation(0 or 1)
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+void
+calibration_compose(calibration_matrix *matrix, int rotate, int mirrorx, int mirrory)
+{
+    calibration_matrix  org = *matrix;
+    int                 lastx = (org.width - 1) << CALIBRATOIN_MATRIX_SHIFT;
+    int                 lasty = (org.height - 1) << CALIBRATOIN_MATRIX_SHIFT;
+
+    switch (rotate) {
+    case 90:
+        /* X = y, Y = (width-1) - x     */
+        matrix->a = org.d;  matrix->b = org.e;  matrix->c = org.f;
+        matrix->d = -org.a; matrix->e = -org.b; matrix->f = lastx - org.c;
+        matrix->width = org.height;
+        matrix->height = org.width;
+        break;
+    case 180:
+        /* X = (width-1) - x, Y = (height-1) - y    */
+        matrix->a = -org.a; matrix->b = -org.b; matrix->c = lastx - org.c;
+        matrix->d = -org.d; matrix->e = -org.e; matrix->f = lasty - org.f;
+        break;
+    case 270:
+        /* X = (height-1) - y, Y = x    */
+        matrix->a = -org.d; matrix->b = -org.e; matrix->c = lasty - org.f;
+        matrix->d = org.a;  matrix->e = org.b;  matrix->f = org.c;
+        matrix->width = org.height;
+        matrix->height = org.width;
+        break;
+    default:
+        break;
+    }
+    if (mirrorx)    {
+        matrix->a = -matrix->a;
+        matrix->b = -matrix->b;
+        matrix->c = ((matrix->width - 1) << CALIBRATOIN_MATRIX_SHIFT) - matrix->c;
+    }
+    if (mirrory)    {
+        matrix->d = -matrix->d;
+        matrix->e = -matrix->e;
+        matrix->f = ((matrix->height - 1) << CALIBRATOIN_MATRIX_SHIFT) - matrix->f;
+    }
+    calibration_select(matrix);
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       select batch kernel specialized for the transform
+ *
+ * @param[in,out] matrix    fixed-point transform
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+void
+calibration_select(calibration_matrix *matrix)
+{
+    if ((matrix->b == 0) && (matrix->d == 0))   {
+        /* axis aligned(0 or 180 rotation without skew)     */
+        matrix->batch = calibration_apply_scale;
+    }
+    else if ((matrix->a == 0) && (matrix->e == 0))  {
+        /* axis swapped(90 or 270 rotation without skew)    */
+        matrix->batch = calibration_apply_swap;
+    }
+    else    {
+        matrix->batch = calibration_apply_batch;
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       convert coordinate of touchpanel to screen
+ *
+ * @param[in]   matrix      fixed-point transform
+ * @param[in]   x           X coordinate of touchpanel
+ * @param[in]   y           Y coordinate of touchpanel
+ * @param[out]  outx        X coordinate of screen(0 to width-1)
+ * @param[out]  outy        Y coordinate of screen(0 to height-1)
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+void
+calibration_apply(const calibration_matrix *matrix, int x, int y, int *outx, int *outy)
+{
+    long long   vx, vy;
+
+    vx = ((long long)matrix->a * x + (long long)matrix->b * y + matrix->c
+          + (1 << (CALIBRATOIN_MATRIX_SHIFT - 1))) >> CALIBRATOIN_MATRIX_SHIFT;
+    vy = ((long long)matrix->d * x + (long long)matrix->e * y + matrix->f
+          + (1 << (CALIBRATOIN_MATRIX_SHIFT - 1))) >> CALIBRATOIN_MATRIX_SHIFT;
+
+    if (vx < 0)                     vx = 0;
+    if (vx >= matrix->width)        vx = matrix->width - 1;
+    if (vy < 0)                     vy = 0;
+    if (vy >= matrix->height)       vy = matrix->height - 1;
+    *outx = (int)vx;
+    *outy = (int)vy;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       convert coordinates of touchpanel to screen(batch)
+ *              X and Y are separate arrays and the loop has no branch,
+ *              so the compiler can vectorize it
+ *
+ * @param[in]   matrix      fixed-point transform
+ * @param[in]   x           X coordinates of touchpanel
+ * @param[in]   y           Y coordinates of touchpanel
+ * @param[out]  outx        X coordinates of screen(0 to width-1)
+ * @param[out]  outy        Y coordinates of screen(0 to height-1)
+ * @param[in]   num         number of coordinates
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+void
+calibration_apply_batch(const calibration_matrix *matrix, const int *x, const int *y,
+                        int *outx, int *outy, int num)
+{
+    const long long a = matrix->a;
+    const long long b = matrix->b;
+    const long long c = matrix->c + (1 << (CALIBRATOIN_MATRIX_SHIFT - 1));
+    const long long d = matrix->d;
+    const long long e = matrix->e;
+    const long long f = matrix->f + (1 << (CALIBRATOIN_MATRIX_SHIFT - 1));
+    const long long maxx = matrix->width - 1;
+    const long long maxy = matrix->height - 1;
+    long long   vx, vy;
+    int         ii;
+
+    for (ii = 0; ii < num; ii++)    {
+        vx = (a * x[ii] + b * y[ii] + c) >> CALIBRATOIN_MATRIX_SHIFT;
+        vy = (d * x[ii] + e * y[ii] + f) >> CALIBRATOIN_MATRIX_SHIFT;
+        /* clamp by min/max(conditional move)   */
+        vx = (vx < 0) ? 0 : vx;
+        vx = (vx > maxx) ? maxx : vx;
+        vy = (vy < 0) ? 0 : vy;
+        vy = (vy > maxy) ? maxy : vy;
+        outx[ii] = (int)vx;
+        outy[ii] = (int)vy;
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       convert coordinates of touchpanel to screen(batch, no skew)
+ *              X depends only on x, and Y only on y
+ *
+ * @param[in]   matrix      fixed-point transform
+ * @param[in]   x           X coordinates of touchpanel
+ * @param[in]   y           Y coordinates of touchpanel
+ * @param[out]  outx        X coordinates of screen(0 to width-1)
+ * @param[out]  outy        Y coordinates of screen(0 to height-1)
+ * @param[in]   num         number of coordinates
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+static void
+calibration_apply_scale(const calibration_matrix *matrix, const int *x, const int *y,
+                        int *outx, int *outy, int num)
+{
+    const long long a = matrix->a;
+    const long long c = matrix->c + (1 << (CALIBRATOIN_MATRIX_SHIFT - 1));
+    const long long e = matrix->e;
+    const long long f = matrix->f + (1 << (CALIBRATOIN_MATRIX_SHIFT - 1));
+    const long long maxx = matrix->width - 1;
+    const long long maxy = matrix->height - 1;
+    long long   vx, vy;
+    int         ii;
+
+    for (ii = 0; ii < num; ii++)    {
+        vx = (a * x[ii] + c) >> CALIBRATOIN_MATRIX_SHIFT;
+        vy = (e * y[ii] + f) >> CALIBRATOIN_MATRIX_SHIFT;
+        vx = (vx < 0) ? 0 : vx;
+        vx = (vx > maxx) ? maxx : vx;
+        vy = (vy < 0) ? 0 : vy;
+        vy = (vy > maxy) ? maxy : vy;
+        outx[ii] = (int)vx;
+        outy[ii] = (int)vy;
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       convert coordinates of touchpanel to screen(batch, swapped)
+ *              X depends only on y, and Y only on x
+ *
+ * @param[in]   matrix      fixed-point transform
+ * @param[in]   x           X coordinates of touchpanel
+ * @param[in]   y           Y coordinates of touchpanel
+ * @param[out]  outx        X coordinates of screen(0 to width-1)
+ * @param[out]  outy        Y coordinates of screen(0 to height-1)
+ * @param[in]   num         number of coordinates
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+static void
+calibration_apply_swap(const calibration_matrix *matrix, const int *x, const int *y,
+                       int *outx, int *outy, int num)
+{
+    const long long b = matrix->b;
+    const long long c = matrix->c + (1 << (CALIBRATOIN_MATRIX_SHIFT - 1));
+    const long long d = matrix->d;
+    const long long f = matrix->f + (1 << (CALIBRATOIN_MATRIX_SHIFT - 1));
+    const long long maxx = matrix->width - 1;
+    const long long maxy = matrix->height - 1;
+    long long   vx, vy;
+    int         ii;
+
+    for (ii = 0; ii < num; ii++)    {
+        vx = (b * y[ii] + c) >> CALIBRATOIN_MATRIX_SHIFT;
+        vy = (d * x[ii] + f) >> CALIBRATOIN_MATRIX_SHIFT;
+        vx = (vx < 0) ? 0 : vx;
+        vx = (vx > maxx) ? maxx : vx;
+        vy = (vy < 0) ? 0 : vy;
+        vy = (vy > maxy) ? maxy : vy;
+        outx[ii] = (int)vx;
+        outy[ii] = (int)vy;
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       initialize jitter filter(1euro filter)
+ *
+ * @param[out]  filter      filter
+ * @param[in]   mincutoff   cutoff frequency(Hz) at rest, lower is smoother
+ * @param[in]   beta        increase of cutoff by speed, higher is less lag
+ * @param[in]   dcutoff     cutoff frequency(Hz) of speed
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+void
+calibration_filter_init(calibration_filter *filter, double mincutoff,
+                        double beta, double dcutoff)
+{
+    filter->mincutoff = mincutoff;
+    filter->beta = beta;
+    filter->dcutoff = (dcutoff > 0.0) ? dcutoff : CALIBRATOIN_FILTER_DCUTOFF;
+    calibration_filter_reset(filter);
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       reset jitter filter, next value is output as it is
+ *              (new contact must not be pulled to the last position)
+ *
+ * @param[in,out] filter    filter
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+void
+calibration_filter_reset(calibration_filter *filter)
+{
+    filter->value = 0.0;
+    filter->speed = 0.0;
+    filter->time = 0;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       filter a coordinate of touchpanel
+ *              low-pass filter whose cutoff rises with the speed, jitter
+ *              at rest is removed and fast move has small lag
+ *
+ * @param[in,out] filter    filter
+ * @param[in]   value       coordinate of touchpanel
+ * @param[in]   time        time of coordinate(us)
+ * @return      filtered coordinate
+ */
+/*--------------------------------------------------------------------------*/
+int
+calibration_filter_apply(calibration_filter *filter, int value, unsigned long long time)
+{
+    double  period;
+    double  speed;
+    double  cutoff;
+
+    if ((filter->mincutoff <= 0.0) || (filter->time == 0))  {
+        /* filter off or first value    */
+        filter->value = value;
+        filter->speed = 0.0;
+        filter->time = time;
+        return value;
+    }
+
+    period = (time > filter->time) ? (double)(time - filter->time) / 1000000.0 : 0.001;
+    filter->time = time;
+
+    /* speed(low-pass filtered) decides cutoff of value */
+    speed = (value - filter->value) / period;
+    filter->speed += calibration_filter_alpha(filter->dcutoff, period) * (speed - filter->speed);
+    cutoff = filter->mincutoff
+           + filter->beta * ((filter->speed < 0) ? -filter->speed : filter->speed);
+    filter->value += calibration_filter_alpha(cutoff, period) * (value - filter->value);
+
+    return (int)((filter->value < 0) ? (filter->value - 0.5) : (filter->value + 0.5));
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       smoothing factor of first order low-pass filter
+ *
+ * @param[in]   cutoff      cutoff frequency(Hz)
+ * @param[in]   period      sampling period(s)
+ * @return      smoothing factor(0.0 to 1.0)
+ */
+/*--------------------------------------------------------------------------*/
+static double
+calibration_filter_alpha(double cutoff, double period)
+{
+    double  tau;
+
+    tau = 1.0 / (2.0 * 3.14159265358979 * cutoff);
+    return 1.0 / (1.0 + tau / period);
+}
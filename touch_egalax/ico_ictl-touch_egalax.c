@@ -14,6 +14,7 @@
  */
 
 #include "ico_ictl-touch_egalax.h"
+#include "ico_ictl-latency.h"
 
 /* Change touch event       */
 #define REPLACE_TOUCH_EVENT 1       /* Change touch event to mouse left button event*/
@@ -21,39 +22,169 @@
 /* Program name             */
 #define     CALIBDAE_DEV_NAME       "ico_ictl-touch_egalax"
 
+/* Multi-touch slot state   */
+typedef struct  _calibration_slot   {
+    int     id;                         /* tracking id(-1: no contact)  */
+    int     x;                          /* raw X coordinate             */
+    int     y;                          /* raw Y coordinate             */
+    int     changed;                    /* changed in frame(MT_CHG_xxx) */
+    int     outx;                       /* last output X of screen      */
+    int     outy;                       /* last output Y of screen      */
+    calibration_filter  fx;             /* jitter filter of X           */
+    calibration_filter  fy;             /* jitter filter of Y           */
+}   calibration_slot;
+#define MT_CHG_ID       1               /* tracking id changed          */
+#define MT_CHG_POS      2               /* position changed             */
+
+/* Touchpanel(input device, output device and region of screen)         */
+typedef struct  _calibration_panel  {
+    /* translation state, used by every event(first cache lines)   */
+    calibration_matrix  matrix;         /* touchpanel to region         */
+    int     regionx;                    /* X of region(combined screen) */
+    int     regiony;                    /* Y of region(combined screen) */
+    int     rawx;                       /* X coordinate of panel        */
+    int     rawy;                       /* Y coordinate of panel        */
+    int     poschanged;                 /* position changed in frame    */
+    int     touchdown;                  /* touch down in frame          */
+    int     outx;                       /* last output X of screen      */
+    int     outy;                       /* last output Y of screen      */
+    int     multitouch;                 /* number of slot(0: single)    */
+    int     slot;                       /* current input slot           */
+    int     outslot;                    /* last output slot             */
+    int     dropping;                   /* discard until SYN_REPORT     */
+    int     split;                      /* frame is written in parts    */
+    int     key;                        /* key event in frame           */
+    int     nframe;                     /* number of output events      */
+    int     evfd;                       /* event input(-1: disconnected)*/
+    int     uifd;                       /* uinput output                */
+    int     retry;                      /* number of read error retry   */
+    calibration_filter  filterx;        /* jitter filter of X           */
+    calibration_filter  filtery;        /* jitter filter of Y           */
+    calibration_slot    slots[CALIBRATOIN_SLOT_NUM];
+    struct input_event  frame[CALIBRATOIN_FRAME_NUM];
+    /* configuration                */
+    char    device[CALIBRATOIN_CONF_LEN_MAX];   /* event device("": search) */
+    char    name[UINPUT_MAX_NAME_SIZE]; /* output device name           */
+    int     dispwidth;                  /* region width                 */
+    int     dispheight;                 /* region height                */
+    int     posx[4];                    /* X of calibration positions   */
+    int     posy[4];                    /* Y of calibration positions   */
+    int     fitted;                     /* MATRIX of N-point calibration*/
+    int     fit[6];                     /* a,b,c,d,e,f of MATRIX        */
+    struct timespec lost;               /* time of disconnect           */
+}   calibration_panel;
+
+/* time of input event(CLOCK_MONOTONIC by EVIOCSCLOCKID) in micro-sec    */
+#define EVENT_USEC(tv)  ((unsigned long long)(tv).tv_sec * 1000000ULL + \
+                         (unsigned long long)(tv).tv_usec)
+
 static void print_usage(const char *pName);
 static char *find_event_device(void);
-static int setup_uinput(char *uinputDeviceName);
-static void set_eventbit(int uifd);
+static int device_held(const char *path);
+static int setup_uinput(char *uinputDeviceName, calibration_panel *panel);
+static int get_absinfo(calibration_panel *panel, int code, struct input_absinfo *absinfo);
+static void set_eventbit(int uifd, calibration_panel *panel);
 static int open_uinput(char *uinputDeviceName);
 static void close_uinput(int uifd);
-static void event_iterate(int uifd, int evfd);
+static void event_iterate(void);
+static int event_panel(calibration_panel *panel, int infd);
+static int open_event_device(calibration_panel *panel);
+static int hotplug_init(void);
+static void release_button(calibration_panel *panel);
+static void set_eventmask(calibration_panel *panel);
+static void set_eventclock(int evfd);
+static void write_frame(calibration_panel *panel, struct input_event *frame, int *nframe);
+static int add_fd(int epfd, int fd);
+static int check_multitouch(calibration_panel *panel);
+static int multitouch_frame(calibration_panel *panel, struct input_event *frame,
+                            struct timeval *tp);
+static int touch_frame(calibration_panel *panel, struct input_event *frame,
+                       struct timeval *tp);
+static int resync_frame(calibration_panel *panel, struct input_event *frame,
+                        struct timeval *tp);
+static int motion_only(calibration_panel *panel);
+static void get_position(calibration_panel *panel);
 static void setup_sighandler(void);
 static void terminate_program(const int signal);
-static int setup_program(void);
-static int calibration_event(struct input_event *in, struct input_event *out);
+static void request_dump(const int signal);
+static void dump_latency(void);
+static void request_reload(const int signal);
+static void request_release(const int signal);
+static void reload_program(int epfd, int regrab);
+static int grab_panel(int epfd, calibration_panel *panel);
+static void close_panel(calibration_panel *panel);
+static void release_panels(int epfd, int release);
+static const char *config_path(void);
+static int config_watch(void);
+static int config_changed(int cffd);
+static void init_panel(calibration_panel *panel, int index);
+static int setup_program(calibration_panel *panels, int *npanel, int *width, int *height);
+static int setup_panel(calibration_panel *panel);
+static int calibration_event(calibration_panel *panel, struct input_event *in,
+                             struct input_event *out);
 static void push_event(struct input_event *ev);
 static void push_eventlog(const char *cmd, const int value, struct timeval *tp);
 
 int             mRunning = -1;          /* Running flag             */
+int             mSigFd = -1;            /* signalfd(TERM/INT/USR1/2/HUP)*/
 int             mDebug = 0;             /* Debug flag               */
 int             mEventLog = 0;          /* event input log          */
 struct timeval  lastEvent = { 0, 0 };   /* last input event time    */
 
-/* Configurations               */
-int             mDispWidth = CALIBRATION_DISP_WIDTH;
-int             mDispHeight = CALIBRATION_DISP_HEIGHT;
-int             mPosX[4] = { 0, 0, 0, 0 };
-int             mPosY[4] = { 0, 0, 0, 0 };
-int             mXlow = 0;
-int             mXheigh = 0;
-int             mYlow = 0;
-int             mYheigh = 0;
+/* Touchpanels(configuration sections)  */
+calibration_panel mPanels[CALIBRATOIN_PANEL_NUM];
+int             mPanelNum = 0;          /* number of panel          */
+int             mScreenWidth = 0;       /* width of combined screen */
+int             mScreenHeight = 0;      /* height of combined screen*/
+
+/* Reload of configuration(SIGHUP or config file is written)    */
+calibration_panel mConfPanels[CALIBRATOIN_PANEL_NUM];   /* parsed, not used */
+volatile int    mReloadConfig = 0;      /* reload request(no signalfd)*/
+int             mReload = 0;            /* number of reload         */
+
+/* Event devices released for calibration tool(SIGUSR2)         */
+volatile int    mReleaseRequest = 0;    /* release request(no signalfd)*/
+int             mCalibrating = 0;       /* event devices are released*/
+
+/* Jitter filter configuration  */
+int             mFilter = 0;            /* 1euro filter on(1)/off(0)*/
+double          mFilterMinCutoff = 0.0; /* min cutoff(Hz, 0: off)   */
+double          mFilterBeta = 0.0;      /* speed coefficient        */
+double          mFilterDCutoff = CALIBRATOIN_FILTER_DCUTOFF;
+int             mStationary = 0;        /* suppress same position   */
+int             mSuppressed = 0;        /* number of suppressed event*/
+
+/* Latency from kernel event time(dump by SIGUSR1)  */
+clockid_t       mEventClock = CLOCK_REALTIME;   /* clock of input event */
+volatile int    mDumpLatency = 0;       /* dump request(no signalfd)*/
+Ico_ICtl_Latency mLatRead;              /* event to read            */
+Ico_ICtl_Latency mLatOutput;            /* event to write or flush  */
+
+/* Motion coalescing            */
+int             mCoalesce = 0;          /* coalesce motion frames   */
+int             mInFrameCount = 0;      /* number of input frame    */
+int             mCoalesced = 0;         /* number of coalesced frame*/
+
+/* Hotplug statistics           */
+int             mReconnect = 0;         /* number of reconnect      */
+int             mDowntime = 0;          /* total downtime(ms)       */
+
+/* Wakeup statistics            */
+int             mWakeup = 0;            /* number of input wakeup   */
+
+/* Event buffer overflow        */
+int             mOverflow = 0;          /* number of SYN_DROPPED    */
+
+/* Output statistics            */
+int             mFrameCount = 0;        /* number of output frame   */
+int             mWriteCount = 0;        /* number of write to uinput*/
+int             mEventCount = 0;        /* number of output event   */
 
 /* Optiones                     */
 int             mTrans = 0;             /* Rotate(0,90,180 or 270)  */
-int             mRevX = 0;              /* Reverse X coordinate     */
-int             mRevY = 0;              /* Reverse Y coordinate     */
+int             mMirrorX = 0;           /* Mirror X(after rotate)   */
+int             mMirrorY = 0;           /* Mirror Y(after rotate)   */
+int             mMask = 1;              /* kernel filter of events  */
 
 /*--------------------------------------------------------------------------*/
 /**
@@ -72,10 +203,9 @@ main(int argc, char *argv[])
 {
     int     ii;
     int     err;
-    int     uifd;                               /* uinput fd */
-    int     evfd;                               /* event device fd */
     char    *eventDeviceName = NULL;            /* event device name to hook */
     char    *uinputDeviceName = "/dev/uinput";  /* User Input module */
+    calibration_panel   *panel;
 
     for (ii = 1; ii < argc; ii++) {
         if (strcmp(argv[ii], "-h") == 0)    {
@@ -100,21 +230,24 @@ main(int argc, char *argv[])
         else if (strcmp(argv[ii], "-L") == 0) {
             mEventLog = 2;                  /* Output Log for Unit Test     */
         }
+        else if (strcmp(argv[ii], "-n") == 0) {
+            mMask = 0;                      /* no kernel filter(to compare) */
+        }
+        else if (strcmp(argv[ii], "-x") == 0) {
+            mMirrorX = 1;                   /* mirror X coordinate          */
+        }
+        else if (strcmp(argv[ii], "-y") == 0) {
+            mMirrorY = 1;                   /* mirror Y coordinate          */
+        }
+        else if (strcmp(argv[ii], "-c") == 0) {
+            mCoalesce = 1;                  /* coalesce motion in a read    */
+        }
         else {
             eventDeviceName = argv[ii];
         }
     }
 
-    if (eventDeviceName == NULL) {
-        /* If event device not present, get default device  */
-        eventDeviceName = find_event_device();
-        if (eventDeviceName == NULL) {
-            /* System has no touchpanel, Error  */
-            exit(9);
-        }
-    }
-
-    err = setup_program();
+    err = setup_program(mPanels, &mPanelNum, &mScreenWidth, &mScreenHeight);
     if (err < 0) {
         if (err == -2)  {
             fprintf(stderr, "%s: Illegal config value\n", argv[0]);
@@ -125,6 +258,18 @@ main(int argc, char *argv[])
         exit(8);
     }
 
+    /* device of command line is the first panel    */
+    if (eventDeviceName != NULL)    {
+        strncpy(mPanels[0].device, eventDeviceName, sizeof(mPanels[0].device) - 1);
+    }
+    if (mPanels[0].device[0] == 0)  {
+        /* If event device not present, get default device  */
+        if (find_event_device() == NULL) {
+            /* System has no touchpanel, Error  */
+            exit(9);
+        }
+    }
+
     if (! mDebug) {
         if (daemon(0, 1) < 0) {
             fprintf(stderr, "%s: Can not Create Daemon\n", argv[0]);
@@ -132,41 +277,109 @@ main(int argc, char *argv[])
         }
     }
 
-    /* setup uinput device      */
-    uifd = setup_uinput(uinputDeviceName);
-    if (uifd < 0) {
-        fprintf(stderr, "uinput(%s) initialize failed. Continue anyway\n", uinputDeviceName);
-        exit(9);
+    for (ii = 0; ii < mPanelNum; ii++)  {
+        panel = &mPanels[ii];
+        panel->evfd = open_event_device(panel);
+        if (panel->evfd < 0) {
+            fprintf(stderr, "event device(%s) Open Error[%d]\n",
+                    (panel->device[0] != 0) ? panel->device : "eGalax", errno);
+            exit(9);
+        }
+        CALIBRATION_DEBUG("main: input device(%s) = %d\n", panel->device, panel->evfd);
+
+        /* output device has multi-touch slots only if input device has */
+        panel->multitouch = check_multitouch(panel);
+        get_position(panel);
     }
 
-    evfd = open(eventDeviceName, O_RDONLY);
-    if (evfd < 0) {
-        fprintf(stderr, "event device(%s) Open Error[%d]\n", eventDeviceName, errno);
-        close_uinput(uifd);
-        exit(9);
+    /* setup uinput device of each panel    */
+    for (ii = 0; ii < mPanelNum; ii++)  {
+        mPanels[ii].uifd = setup_uinput(uinputDeviceName, &mPanels[ii]);
+        if (mPanels[ii].uifd < 0) {
+            fprintf(stderr, "uinput(%s) initialize failed. Continue anyway\n", uinputDeviceName);
+            exit(9);
+        }
     }
-    CALIBRATION_DEBUG("main: input device(%s) = %d\n", eventDeviceName, evfd);
 
     setup_sighandler();
+    ico_ictl_latency_init(&mLatRead, "event-read");
+    ico_ictl_latency_init(&mLatOutput, "event-write");
 
     /* event read               */
     mRunning = 1;
-    event_iterate(uifd, evfd);
+    event_iterate();
 
-    if (evfd >= 0)  {
-        close(evfd);
+    for (ii = 0; ii < mPanelNum; ii++)  {
+        if (mPanels[ii].evfd >= 0)  {
+            close(mPanels[ii].evfd);
+        }
+        close_uinput(mPanels[ii].uifd);
+    }
+    if (mSigFd >= 0)    {
+        close(mSigFd);
     }
-
-    close_uinput(uifd);
 
     exit(0);
 }
 
 /*--------------------------------------------------------------------------*/
 /**
- * @brief       initialize with get configurations
+ * @brief       initialize a panel(configuration section) by default value
+ *
+ * @param[out]  panel       touchpanel
+ * @param[in]   index       panel number(name of output device)
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+static void
+init_panel(calibration_panel *panel, int index)
+{
+    memset(panel, 0, sizeof(calibration_panel));
+    panel->dispwidth = CALIBRATION_DISP_WIDTH;
+    panel->dispheight = CALIBRATION_DISP_HEIGHT;
+    panel->outx = -1;
+    panel->outy = -1;
+    panel->outslot = -1;
+    panel->evfd = -1;
+    panel->uifd = -1;
+    if (index == 0) {
+        strcpy(panel->name, CALIBDAE_DEV_NAME);
+    }
+    else    {
+        snprintf(panel->name, sizeof(panel->name), "%s-%d", CALIBDAE_DEV_NAME, index);
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       path of configuration file
  *
  * @param       nothing
+ * @return      path(environment CALIBRATOIN_CONF or default)
+ */
+/*--------------------------------------------------------------------------*/
+static const char *
+config_path(void)
+{
+    const char  *confp;
+
+    confp = getenv(CALIBRATOIN_CONF_ENV);
+    if (! confp)  {
+        confp = CALIBRATOIN_CONF_FILE;
+    }
+    return confp;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       initialize with get configurations
+ *              keys before the first [PANEL] line and after each [PANEL]
+ *              line are the configuration of a touchpanel
+ *
+ * @param[out]  panels      touchpanels(configuration sections)
+ * @param[out]  npanel      number of panel
+ * @param[out]  width       width of combined screen
+ * @param[out]  height      height of combined screen
  * @return      result
  * @retval      0           sucess
  * @retval      -1          config file read error
@@ -174,18 +387,18 @@ main(int argc, char *argv[])
  */
 /*--------------------------------------------------------------------------*/
 static int
-setup_program(void)
+setup_program(calibration_panel *panels, int *npanel, int *width, int *height)
 {
-    char    *confp;
+    const char  *confp;
     char    buff[128];
+    char    *value;
     FILE    *fp;
-    int     work;
+    int     nkey;
+    int     ii;
+    calibration_panel   *panel;
 
     /* Get configuration file path  */
-    confp = getenv(CALIBRATOIN_CONF_ENV);
-    if (! confp)  {
-        confp = CALIBRATOIN_CONF_FILE;
-    }
+    confp = config_path();
 
     /* Open configuration file      */
     fp = fopen(confp, "r");
@@ -194,110 +407,462 @@ setup_program(void)
         return -1;
     }
 
+    /* keys not in the file are default(same as start, also for reload)  */
+    mFilterMinCutoff = 0.0;
+    mFilterBeta = 0.0;
+    mFilterDCutoff = CALIBRATOIN_FILTER_DCUTOFF;
+    mStationary = 0;
+
+    *npanel = 0;
+    panel = &panels[0];
+    init_panel(panel, (*npanel)++);
+    nkey = 0;
     while (fgets(buff, sizeof(buff), fp)) {
         if (buff[0] == '#') {
             /* comment line, skip       */
             continue;
         }
+        else if (strncmp(buff,
+                         CALIBRATOIN_STR_PANEL,
+                         sizeof(CALIBRATOIN_STR_PANEL) - 1) == 0) {
+            /* start of next touchpanel */
+            if (nkey == 0)  {
+                /* no configuration before the first [PANEL]    */
+                continue;
+            }
+            if (*npanel >= CALIBRATOIN_PANEL_NUM) {
+                CALIBRATION_PRINT("%s: too many panels(max %d)\n",
+                                  CALIBDAE_DEV_NAME, CALIBRATOIN_PANEL_NUM);
+                fclose(fp);
+                return -2;
+            }
+            panel = &panels[*npanel];
+            init_panel(panel, (*npanel)++);
+            nkey = 0;
+            CALIBRATION_INFO("PANEL %d\n", *npanel - 1);
+            continue;
+        }
+        else if (strncmp(buff,
+                         CALIBRATOIN_STR_DEVICE,
+                         sizeof(CALIBRATOIN_STR_DEVICE) - 1) == 0) {
+            /* event device of panel    */
+            nkey ++;
+            strtok(buff, CALIBRATOIN_STR_SEPAR);
+            value = strtok(NULL, CALIBRATOIN_STR_SEPAR " \t\r\n");
+            if (value)  {
+                strncpy(panel->device, value, sizeof(panel->device) - 1);
+            }
+            CALIBRATION_INFO("DEVICE = %s\n", panel->device);
+        }
+        else if (strncmp(buff,
+                         CALIBRATOIN_STR_REGION,
+                         sizeof(CALIBRATOIN_STR_REGION) - 1) == 0) {
+            /* region of combined screen */
+            nkey ++;
+            strtok(buff, CALIBRATOIN_STR_SEPAR);
+            panel->regionx = atoi(strtok(NULL, CALIBRATOIN_STR_SEPAR));
+            panel->regiony = atoi(strtok(NULL, CALIBRATOIN_STR_SEPAR));
+            CALIBRATION_INFO("REGION = %dx%d\n", panel->regionx, panel->regiony);
+        }
         else if (strncmp(buff,
                          CALIBRATOIN_STR_DISP_W,
                          sizeof(CALIBRATOIN_STR_DISP_W) - 1) == 0) {
             /* screen width             */
+            nkey ++;
             strtok(buff, CALIBRATOIN_STR_SEPAR);
-            mDispWidth = atoi(strtok(NULL, CALIBRATOIN_STR_SEPAR));
-            CALIBRATION_INFO("mDispWidth = %d\n", mDispWidth);
+            panel->dispwidth = atoi(strtok(NULL, CALIBRATOIN_STR_SEPAR));
+            CALIBRATION_INFO("DispWidth = %d\n", panel->dispwidth);
         }
         else if (strncmp(buff,
                          CALIBRATOIN_STR_DISP_H,
                          sizeof(CALIBRATOIN_STR_DISP_H) - 1) == 0) {
             /* screen height            */
+            nkey ++;
             strtok(buff, CALIBRATOIN_STR_SEPAR);
-            mDispHeight = atoi(strtok(NULL, CALIBRATOIN_STR_SEPAR));
-            CALIBRATION_INFO("mDispHeight = %d\n", mDispHeight);
+            panel->dispheight = atoi(strtok(NULL, CALIBRATOIN_STR_SEPAR));
+            CALIBRATION_INFO("DispHeight = %d\n", panel->dispheight);
         }
         else if (strncmp(buff,
                          CALIBRATOIN_STR_POS1,
                          sizeof(CALIBRATOIN_STR_POS1) - 1) == 0) {
             /* position1 : Top-Left     */
+            nkey ++;
             strtok(buff, CALIBRATOIN_STR_SEPAR);
-            mPosX[0] = atoi(strtok(NULL, CALIBRATOIN_STR_SEPAR));
-            mPosY[0] = atoi(strtok(NULL, CALIBRATOIN_STR_SEPAR));
-            CALIBRATION_INFO("POS1 = %dx%d\n", mPosX[0], mPosY[0]);
+            panel->posx[0] = atoi(strtok(NULL, CALIBRATOIN_STR_SEPAR));
+            panel->posy[0] = atoi(strtok(NULL, CALIBRATOIN_STR_SEPAR));
+            CALIBRATION_INFO("POS1 = %dx%d\n", panel->posx[0], panel->posy[0]);
         }
         else if (strncmp(buff,
                          CALIBRATOIN_STR_POS2,
                          sizeof(CALIBRATOIN_STR_POS2) - 1) == 0) {
             /* position2 : Top-Right    */
+            nkey ++;
             strtok(buff, CALIBRATOIN_STR_SEPAR);
-            mPosX[1] = atoi(strtok(NULL, CALIBRATOIN_STR_SEPAR));
-            mPosY[1] = atoi(strtok(NULL, CALIBRATOIN_STR_SEPAR));
-            CALIBRATION_INFO("POS2 = %dx%d\n", mPosX[1], mPosY[1]);
+            panel->posx[1] = atoi(strtok(NULL, CALIBRATOIN_STR_SEPAR));
+            panel->posy[1] = atoi(strtok(NULL, CALIBRATOIN_STR_SEPAR));
+            CALIBRATION_INFO("POS2 = %dx%d\n", panel->posx[1], panel->posy[1]);
         }
         else if (strncmp(buff,
                          CALIBRATOIN_STR_POS3,
                          sizeof(CALIBRATOIN_STR_POS3) - 1) == 0) {
             /* position3 : Bottom-Left  */
+            nkey ++;
             strtok(buff, CALIBRATOIN_STR_SEPAR);
-            mPosX[2] = atoi(strtok(NULL, CALIBRATOIN_STR_SEPAR));
-            mPosY[2] = atoi(strtok(NULL, CALIBRATOIN_STR_SEPAR));
-            CALIBRATION_INFO("POS3 = %dx%d\n", mPosX[2], mPosY[2]);
+            panel->posx[2] = atoi(strtok(NULL, CALIBRATOIN_STR_SEPAR));
+            panel->posy[2] = atoi(strtok(NULL, CALIBRATOIN_STR_SEPAR));
+            CALIBRATION_INFO("POS3 = %dx%d\n", panel->posx[2], panel->posy[2]);
         }
         else if (strncmp(buff,
                          CALIBRATOIN_STR_POS4,
                          sizeof(CALIBRATOIN_STR_POS4) - 1) == 0) {
             /* position4 : Bottom-Right */
+            nkey ++;
+            strtok(buff, CALIBRATOIN_STR_SEPAR);
+            panel->posx[3] = atoi(strtok(NULL, CALIBRATOIN_STR_SEPAR));
+            panel->posy[3] = atoi(strtok(NULL, CALIBRATOIN_STR_SEPAR));
+            CALIBRATION_INFO("POS4 = %dx%d\n", panel->posx[3], panel->posy[3]);
+        }
+        else if (strncmp(buff,
+                         CALIBRATOIN_STR_MATRIX,
+                         sizeof(CALIBRATOIN_STR_MATRIX) - 1) == 0) {
+            /* transform of N-point calibration(used instead of positions)  */
+            nkey ++;
+            strtok(buff, CALIBRATOIN_STR_SEPAR);
+            for (ii = 0; ii < 6; ii++)  {
+                value = strtok(NULL, CALIBRATOIN_STR_SEPAR);
+                if (! value)    break;
+                panel->fit[ii] = atoi(value);
+            }
+            panel->fitted = (ii == 6) ? 1 : 0;
+            CALIBRATION_INFO("MATRIX = %d %d %d %d %d %d\n",
+                             panel->fit[0], panel->fit[1], panel->fit[2],
+                             panel->fit[3], panel->fit[4], panel->fit[5]);
+        }
+        else if (strncmp(buff,
+                         CALIBRATOIN_STR_FLT_MIN,
+                         sizeof(CALIBRATOIN_STR_FLT_MIN) - 1) == 0) {
+            /* jitter filter : min cutoff   */
+            strtok(buff, CALIBRATOIN_STR_SEPAR);
+            mFilterMinCutoff = atof(strtok(NULL, CALIBRATOIN_STR_SEPAR));
+            CALIBRATION_INFO("FILTER_MINCUTOFF = %.3f\n", mFilterMinCutoff);
+        }
+        else if (strncmp(buff,
+                         CALIBRATOIN_STR_FLT_BETA,
+                         sizeof(CALIBRATOIN_STR_FLT_BETA) - 1) == 0) {
+            /* jitter filter : beta         */
+            strtok(buff, CALIBRATOIN_STR_SEPAR);
+            mFilterBeta = atof(strtok(NULL, CALIBRATOIN_STR_SEPAR));
+            CALIBRATION_INFO("FILTER_BETA = %.5f\n", mFilterBeta);
+        }
+        else if (strncmp(buff,
+                         CALIBRATOIN_STR_FLT_DCUT,
+                         sizeof(CALIBRATOIN_STR_FLT_DCUT) - 1) == 0) {
+            /* jitter filter : speed cutoff */
+            strtok(buff, CALIBRATOIN_STR_SEPAR);
+            mFilterDCutoff = atof(strtok(NULL, CALIBRATOIN_STR_SEPAR));
+            CALIBRATION_INFO("FILTER_DCUTOFF = %.3f\n", mFilterDCutoff);
+        }
+        else if (strncmp(buff,
+                         CALIBRATOIN_STR_FLT_STAY,
+                         sizeof(CALIBRATOIN_STR_FLT_STAY) - 1) == 0) {
+            /* suppress same position       */
             strtok(buff, CALIBRATOIN_STR_SEPAR);
-            mPosX[3] = atoi(strtok(NULL, CALIBRATOIN_STR_SEPAR));
-            mPosY[3] = atoi(strtok(NULL, CALIBRATOIN_STR_SEPAR));
-            CALIBRATION_INFO("POS4 = %dx%d\n", mPosX[3], mPosY[3]);
+            mStationary = atoi(strtok(NULL, CALIBRATOIN_STR_SEPAR));
+            CALIBRATION_INFO("FILTER_STATIONARY = %d\n", mStationary);
         }
     }
     fclose(fp);
+    if ((nkey == 0) && (*npanel > 1)) {
+        /* [PANEL] line without configuration   */
+        (*npanel) --;
+    }
 
-    /* Reverse X coordinate, if need    */
-    if (mPosX[0] > mPosX[1])    {
-        int     work;
-        work = mPosX[0];
-        mPosX[0] = mPosX[1];
-        mPosX[1] = work;
-        work = mPosX[2];
-        mPosX[2] = mPosX[3];
-        mPosX[3] = work;
-        mRevX = 1;
-        CALIBRATION_INFO("Reverse X\n");
-    }
-
-    /* Reverse Y coordinate, if need    */
-    if (mPosY[0] > mPosY[2])    {
-        work = mPosY[0];
-        mPosY[0] = mPosY[2];
-        mPosY[2] = work;
-        work = mPosY[1];
-        mPosY[1] = mPosY[3];
-        mPosY[3] = work;
-        mRevY = 1;
-        CALIBRATION_INFO("Reverse Y\n");
-    }
-
-    if ((mRevX != 0) || (mRevY != 0))   {
-        CALIBRATION_INFO("Changed POS1 = %dx%d\n", mPosX[0], mPosY[0]);
-        CALIBRATION_INFO("Changed POS2 = %dx%d\n", mPosX[1], mPosY[1]);
-        CALIBRATION_INFO("Changed POS3 = %dx%d\n", mPosX[2], mPosY[2]);
-        CALIBRATION_INFO("Changed POS4 = %dx%d\n", mPosX[3], mPosY[3]);
-    }
-
-    mXlow = (mPosX[0] + mPosX[2]) / 2;
-    mXheigh = (mPosX[1] + mPosX[3]) / 2;
-    if (mXheigh <= mXlow)   {
-        return -2;
-    }
-
-    mYlow = (mPosY[0] + mPosY[1]) / 2;
-    mYheigh = (mPosY[2] + mPosY[3]) / 2;
-    if (mYheigh <= mYlow)   {
-        return -2;
+    mFilter = (mFilterMinCutoff > 0.0) ? 1 : 0;
+    *width = 0;
+    *height = 0;
+    for (ii = 0; ii < *npanel; ii++)  {
+        panel = &panels[ii];
+        if ((ii > 0) && (panel->device[0] == 0))    {
+            /* only the first panel can be searched */
+            CALIBRATION_PRINT("%s: panel %d has no %s\n",
+                              CALIBDAE_DEV_NAME, ii, CALIBRATOIN_STR_DEVICE);
+            return -2;
+        }
+        if (setup_panel(panel) < 0) {
+            return -2;
+        }
+        /* combined screen includes all regions */
+        if ((panel->regionx + panel->matrix.width) > *width)  {
+            *width = panel->regionx + panel->matrix.width;
+        }
+        if ((panel->regiony + panel->matrix.height) > *height)    {
+            *height = panel->regiony + panel->matrix.height;
+        }
     }
-    return 1;
+    CALIBRATION_INFO("%d panel(s), screen %dx%d\n", *npanel, *width, *height);
+    return 0;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       calibration matrix and jitter filter of a touchpanel
+ *
+ * @param[in,out] panel     touchpanel
+ * @return      result
+ * @retval      0           sucess
+ * @retval      -1          illegal config value
+ */
+/*--------------------------------------------------------------------------*/
+static int
+setup_panel(calibration_panel *panel)
+{
+    int     dispX[4];
+    int     dispY[4];
+    int     ii;
+
+    /* jitter filter of single touch and multi-touch slots */
+    calibration_filter_init(&panel->filterx, mFilterMinCutoff, mFilterBeta, mFilterDCutoff);
+    calibration_filter_init(&panel->filtery, mFilterMinCutoff, mFilterBeta, mFilterDCutoff);
+    for (ii = 0; ii < CALIBRATOIN_SLOT_NUM; ii++)   {
+        calibration_filter_init(&panel->slots[ii].fx, mFilterMinCutoff, mFilterBeta, mFilterDCutoff);
+        calibration_filter_init(&panel->slots[ii].fy, mFilterMinCutoff, mFilterBeta, mFilterDCutoff);
+    }
+
+    if ((panel->regionx < 0) || (panel->regiony < 0))   {
+        return -1;
+    }
+
+    if (panel->fitted)  {
+        /* transform fitted by N-point calibration tool */
+        if ((panel->dispwidth <= 0) || (panel->dispheight <= 0))    {
+            return -1;
+        }
+        panel->matrix.a = panel->fit[0];
+        panel->matrix.b = panel->fit[1];
+        panel->matrix.c = panel->fit[2];
+        panel->matrix.d = panel->fit[3];
+        panel->matrix.e = panel->fit[4];
+        panel->matrix.f = panel->fit[5];
+        panel->matrix.width = panel->dispwidth;
+        panel->matrix.height = panel->dispheight;
+        calibration_select(&panel->matrix);
+    }
+    else    {
+        /* affine transform of 4 corners(least squares)  */
+        dispX[0] = 0;                   dispY[0] = 0;
+        dispX[1] = panel->dispwidth;    dispY[1] = 0;
+        dispX[2] = 0;                   dispY[2] = panel->dispheight;
+        dispX[3] = panel->dispwidth;    dispY[3] = panel->dispheight;
+        if (calibration_fit(&panel->matrix, panel->posx, panel->posy, dispX, dispY, 4,
+                            panel->dispwidth, panel->dispheight) != 0)   {
+            return -1;
+        }
+    }
+    /* rotation and mirror are composed into the matrix */
+    calibration_compose(&panel->matrix, mTrans, mMirrorX, mMirrorY);
+    CALIBRATION_INFO("Matrix X = %d %d %d, Y = %d %d %d (>>%d) region %d,%d\n",
+                     panel->matrix.a, panel->matrix.b, panel->matrix.c,
+                     panel->matrix.d, panel->matrix.e, panel->matrix.f,
+                     CALIBRATOIN_MATRIX_SHIFT, panel->regionx, panel->regiony);
+    return 0;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       reload configuration without restart(SIGHUP or config file
+ *              is written). calibration, region and jitter filter of the
+ *              running panels are replaced, event devices and uinput
+ *              devices are kept. called from the event loop between reads,
+ *              and the matrix is used only at SYN_REPORT, so every frame
+ *              is translated by either old or new calibration.
+ *              number of panels, their devices and size of combined screen
+ *              (range of uinput device) can not be changed by reload.
+ *              event devices released for calibration tool(SIGUSR2) are
+ *              grabbed again by the new calibration, only when the file is
+ *              replaced by rename as the tool writes it.
+ *
+ * @param[in]   epfd        epoll file descriptor of event loop
+ * @param[in]   regrab      file is replaced(grab released event devices)
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+static void
+reload_program(int epfd, int regrab)
+{
+    double  mincutoff = mFilterMinCutoff;
+    double  beta = mFilterBeta;
+    double  dcutoff = mFilterDCutoff;
+    int     stationary = mStationary;
+    int     npanel, width, height;
+    int     err;
+    int     ii;
+    calibration_panel   *panel;
+    calibration_panel   *conf;
+
+    err = setup_program(mConfPanels, &npanel, &width, &height);
+    if (err >= 0)   {
+        if ((npanel != mPanelNum) || (width != mScreenWidth) || (height != mScreenHeight)) {
+            CALIBRATION_PRINT("%s: panels or screen(%dx%d) changed, restart to apply\n",
+                              CALIBDAE_DEV_NAME, width, height);
+            err = -3;
+        }
+        /* event device of the first panel may be command line or searched */
+        for (ii = 1; (err >= 0) && (ii < npanel); ii++) {
+            if (strcmp(mConfPanels[ii].device, mPanels[ii].device) != 0)    {
+                CALIBRATION_PRINT("%s: %s of panel %d changed, restart to apply\n",
+                                  CALIBDAE_DEV_NAME, CALIBRATOIN_STR_DEVICE, ii);
+                err = -3;
+            }
+        }
+    }
+    if (err < 0)    {
+        /* keep running configuration   */
+        mFilterMinCutoff = mincutoff;
+        mFilterBeta = beta;
+        mFilterDCutoff = dcutoff;
+        mStationary = stationary;
+        mFilter = (mFilterMinCutoff > 0.0) ? 1 : 0;
+        CALIBRATION_PRINT("%s: configuration not reloaded(%d)\n", CALIBDAE_DEV_NAME, err);
+        return;
+    }
+
+    for (ii = 0; ii < mPanelNum; ii++)  {
+        panel = &mPanels[ii];
+        conf = &mConfPanels[ii];
+        panel->regionx = conf->regionx;
+        panel->regiony = conf->regiony;
+        panel->dispwidth = conf->dispwidth;
+        panel->dispheight = conf->dispheight;
+        memcpy(panel->posx, conf->posx, sizeof(panel->posx));
+        memcpy(panel->posy, conf->posy, sizeof(panel->posy));
+        panel->fitted = conf->fitted;
+        memcpy(panel->fit, conf->fit, sizeof(panel->fit));
+        /* same result as the parsed section, checked by setup_program  */
+        setup_panel(panel);
+    }
+    mReload ++;
+    CALIBRATION_PRINT("%s: configuration reloaded(%d)\n", CALIBDAE_DEV_NAME, mReload);
+    if ((mCalibrating) && (regrab)) {
+        /* calibration tool wrote the configuration */
+        release_panels(epfd, 0);
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       release or grab event devices of all panels for the
+ *              calibration tool(SIGUSR2). released devices are closed, so
+ *              touches to the tool are not queued for the daemon, and
+ *              reopened by the reload of the written configuration or
+ *              the next SIGUSR2
+ *
+ * @param[in]   epfd        epoll file descriptor of event loop
+ * @param[in]   release     release(1) or grab(0)
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+static void
+release_panels(int epfd, int release)
+{
+    int     ii;
+
+    for (ii = 0; ii < mPanelNum; ii++)  {
+        if (release)    {
+            if (mPanels[ii].evfd >= 0)  {
+                close_panel(&mPanels[ii]);
+            }
+        }
+        else if (mPanels[ii].evfd < 0)  {
+            if (grab_panel(epfd, &mPanels[ii]) < 0) {
+                /* device is reopened by hotplug    */
+                CALIBRATION_PRINT("%s: input device not found, wait for reconnect\n",
+                                  mPanels[ii].name);
+            }
+        }
+    }
+    mCalibrating = release;
+    CALIBRATION_PRINT("%s: input devices %s\n", CALIBDAE_DEV_NAME,
+                      release ? "released for calibration" : "grabbed");
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       watch configuration file. directory is watched, because
+ *              the calibration tool and editors replace the file by rename
+ *
+ * @param       nothing
+ * @return      inotify file descriptor
+ * @retval      >= 0        file descriptor
+ * @retval      < 0         error
+ */
+/*--------------------------------------------------------------------------*/
+static int
+config_watch(void)
+{
+    const char  *confp;
+    const char  *name;
+    char    dir[CALIBRATOIN_CONF_LEN_MAX];
+    int     cffd;
+
+    confp = config_path();
+    name = strrchr(confp, '/');
+    if (name == NULL)   {
+        strcpy(dir, ".");
+    }
+    else if (name == confp) {
+        strcpy(dir, "/");
+    }
+    else    {
+        snprintf(dir, sizeof(dir), "%.*s", (int)(name - confp), confp);
+    }
+
+    cffd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (cffd < 0)   {
+        CALIBRATION_PRINT("config_watch: inotify init Error[%d]\n", errno);
+        return -1;
+    }
+    if (inotify_add_watch(cffd, dir, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        CALIBRATION_PRINT("config_watch: inotify watch(%s) Error[%d]\n", dir, errno);
+        close(cffd);
+        return -1;
+    }
+    return cffd;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       read events of config_watch
+ *
+ * @param[in]   cffd        inotify file descriptor(config_watch)
+ * @return      events of configuration file
+ * @retval      IN_CLOSE_WRITE  written
+ * @retval      IN_MOVED_TO     replaced by rename(calibration tool)
+ * @retval      0           other file of the directory
+ */
+/*--------------------------------------------------------------------------*/
+static int
+config_changed(int cffd)
+{
+    const char  *name;
+    char    inbuf[4096]
+            __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    struct inotify_event    *iev;
+    int     changed = 0;
+    int     len;
+    int     pos;
+
+    name = strrchr(config_path(), '/');
+    name = (name != NULL) ? (name + 1) : config_path();
+
+    while ((len = read(cffd, inbuf, sizeof(inbuf))) > 0)    {
+        for (pos = 0; pos < len; pos += sizeof(struct inotify_event) + iev->len)  {
+            iev = (struct inotify_event *)&inbuf[pos];
+            if ((iev->len > 0) && (strcmp(iev->name, name) == 0))   {
+                changed |= iev->mask & (IN_CLOSE_WRITE | IN_MOVED_TO);
+            }
+        }
+    }
+    return changed;
 }
 
 /*--------------------------------------------------------------------------*/
@@ -317,7 +882,68 @@ terminate_program(const int signal)
 
 /*--------------------------------------------------------------------------*/
 /**
- * @brief       setup signal handler
+ * @brief       signal handler of latency dump(SIGUSR1, no signalfd)
+ *
+ * @param[in]   signal  signal numnber
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+static void
+request_dump(const int signal)
+{
+    mDumpLatency = 1;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       signal handler of configuration reload(SIGHUP, no signalfd)
+ *
+ * @param[in]   signal  signal numnber
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+static void
+request_reload(const int signal)
+{
+    mReloadConfig = 1;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       signal handler of device release(SIGUSR2, no signalfd)
+ *
+ * @param[in]   signal  signal numnber
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+static void
+request_release(const int signal)
+{
+    mReleaseRequest = 1;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       print latency histograms(p50/p99/p99.9)
+ *
+ * @param       nothing
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+static void
+dump_latency(void)
+{
+    char    buf[160];
+
+    ico_ictl_latency_format(&mLatRead, buf, sizeof(buf));
+    CALIBRATION_PRINT("%s: %s\n", CALIBDAE_DEV_NAME, buf);
+    ico_ictl_latency_format(&mLatOutput, buf, sizeof(buf));
+    CALIBRATION_PRINT("%s: %s\n", CALIBDAE_DEV_NAME, buf);
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       setup signal handler(signalfd)
  *
  * @param       nothing
  * @return      nothing
@@ -329,10 +955,26 @@ setup_sighandler(void)
     sigset_t    mask;
 
     sigemptyset(&mask);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGUSR1);
+    sigaddset(&mask, SIGUSR2);
+    sigaddset(&mask, SIGHUP);
+
+    /* signals are read from signalfd in the event loop */
+    sigprocmask(SIG_BLOCK, &mask, NULL);
+    mSigFd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (mSigFd >= 0)    {
+        return;
+    }
+    CALIBRATION_PRINT("setup_sighandler: signalfd Error[%d]\n", errno);
 
+    /* no signalfd, signal handler interrupts epoll_wait    */
     signal(SIGTERM, terminate_program);
-
-    sigaddset(&mask, SIGTERM);
+    signal(SIGINT, terminate_program);
+    signal(SIGUSR1, request_dump);
+    signal(SIGUSR2, request_release);
+    signal(SIGHUP, request_reload);
     sigprocmask(SIG_UNBLOCK, &mask, NULL);
 }
 
@@ -365,6 +1007,11 @@ find_event_device(void)
             snprintf(edevice, 64, "/dev/input/event%d", i);
             fd = open(edevice, O_RDONLY | O_NONBLOCK);
             if (fd < 0)     continue;
+            if (device_held(edevice))   {
+                /* DEVICE of other panel    */
+                close(fd);
+                continue;
+            }
 
             memset(buf, 0, sizeof(buf));
             ioctl(fd, EVIOCGNAME(sizeof(buf)), buf);
@@ -416,6 +1063,11 @@ find_event_device(void)
                                 edevice[k] = buf[j];
                             }
                             edevice[k] = 0;
+                            if (device_held(edevice))   {
+                                /* DEVICE of other panel, search next eGalax    */
+                                eGalax = 0;
+                                break;
+                            }
                             CALIBRATION_INFO("Event device of eGalax=<%s>\n", edevice);
                             fclose(fp);
                             return edevice;
@@ -433,97 +1085,778 @@ find_event_device(void)
 
 /*--------------------------------------------------------------------------*/
 /**
- * @brief       event input and convert (main loop)
+ * @brief       check that a device node is DEVICE of other panel
+ *              (only the first panel is searched, so the other panels
+ *              have DEVICE and the search must not take their node)
  *
- *
- * @param[in]   uifd        event output file descriptor
- * @param[in]   evfd        event input file descriptor
- * @return      nothing
+ * @param[in]   path        device file
+ * @return      result
+ * @retval      1           same node as DEVICE of other panel
+ * @retval      0           not used by other panel
  */
 /*--------------------------------------------------------------------------*/
-static void
-event_iterate(int uifd, int evfd)
+static int
+device_held(const char *path)
 {
-    fd_set      fds;
-    int         ret;
-    int         rsize;
-    int         ii;
-    int         retry;
-    struct timeval  delay;
-    struct input_event events[128];
-    struct input_event event;
+    struct stat st;
+    struct stat other;
+    int     ii;
 
-    ioctl(evfd, EVIOCGRAB, 1);
+    if ((stat(path, &st) < 0) || (! S_ISCHR(st.st_mode)))  {
+        return 0;
+    }
+    for (ii = 1; ii < mPanelNum; ii++)  {
+        if ((mPanels[ii].device[0] != 0) && (stat(mPanels[ii].device, &other) == 0) &&
+            (other.st_rdev == st.st_rdev))  {
+            return 1;
+        }
+    }
+    return 0;
+}
 
-    retry = 0;
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       open event device of a touchpanel(also reconnect)
+ *
+ * @param[in]   panel       touchpanel
+ * @return      event device file descriptor
+ * @retval      >= 0        file descriptor
+ * @retval      < 0         device not found or open error
+ */
+/*--------------------------------------------------------------------------*/
+static int
+open_event_device(calibration_panel *panel)
+{
+    char    *eventDeviceName;
 
-    while (mRunning > 0) {
-        delay.tv_sec = 1;
-        delay.tv_usec = 0;
+    eventDeviceName = panel->device;
+    if (eventDeviceName[0] == 0)    {
+        /* event device number may be changed by reconnect  */
+        eventDeviceName = find_event_device();
+        if (eventDeviceName == NULL)    {
+            return -1;
+        }
+    }
+    return open(eventDeviceName, O_RDONLY);
+}
 
-        FD_ZERO(&fds);
-        FD_SET(evfd, &fds);
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       watch input device directory for hotplug
+ *
+ * @param       nothing
+ * @return      inotify file descriptor
+ * @retval      >= 0        file descriptor
+ * @retval      < 0         error
+ */
+/*--------------------------------------------------------------------------*/
+static int
+hotplug_init(void)
+{
+    int     infd;
 
-        ret = select(evfd + 1, &fds, NULL, NULL, &delay);
-        if (ret <= 0) {
+    infd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (infd < 0)   {
+        CALIBRATION_PRINT("hotplug_init: inotify init Error[%d]\n", errno);
+        return -1;
+    }
+    /* device file is created, and then udev changes its permission */
+    if (inotify_add_watch(infd, CALIBRATOIN_HOTPLUG_DIR, IN_CREATE | IN_ATTRIB) < 0) {
+        CALIBRATION_PRINT("hotplug_init: inotify watch Error[%d]\n", errno);
+        close(infd);
+        return -1;
+    }
+    return infd;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       open and grab event device of a touchpanel(start, reconnect
+ *              or end of calibration)
+ *
+ * @param[in]   epfd        epoll file descriptor of event loop
+ * @param[in,out] panel     touchpanel(event device is closed)
+ * @return      event device file descriptor
+ * @retval      >= 0        file descriptor
+ * @retval      < 0         device not found or open error
+ */
+/*--------------------------------------------------------------------------*/
+static int
+grab_panel(int epfd, calibration_panel *panel)
+{
+    panel->evfd = open_event_device(panel);
+    if (panel->evfd >= 0)   {
+        add_fd(epfd, panel->evfd);
+        ioctl(panel->evfd, EVIOCGRAB, 1);
+        set_eventmask(panel);
+        set_eventclock(panel->evfd);
+        get_position(panel);
+    }
+    return panel->evfd;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       close event device of a touchpanel(unplug or calibration),
+ *              incomplete frame is discarded and button is released
+ *
+ * @param[in,out] panel     touchpanel
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+static void
+close_panel(calibration_panel *panel)
+{
+    int     ii;
+
+    close(panel->evfd);                 /* also removed from epoll  */
+    panel->evfd = -1;
+    panel->retry = 0;
+    panel->nframe = 0;                  /* discard incomplete frame */
+    panel->split = 0;
+    panel->key = 0;
+    panel->dropping = 0;
+    /* end contacts before the slot state is reset  */
+    release_button(panel);
+    if (panel->multitouch > 0)  {
+        /* reopened device reports contacts again   */
+        for (ii = 0; ii < panel->multitouch; ii++)  {
+            panel->slots[ii].id = -1;
+            panel->slots[ii].changed = 0;
+        }
+        panel->slot = 0;
+        panel->outslot = -1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &panel->lost);
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       add file descriptor to epoll
+ *
+ * @param[in]   epfd        epoll file descriptor
+ * @param[in]   fd          file descriptor to wait input(< 0: ignored)
+ * @return      result
+ * @retval      0           sucess
+ * @retval      -1          error
+ */
+/*--------------------------------------------------------------------------*/
+static int
+add_fd(int epfd, int fd)
+{
+    struct epoll_event  ev;
+
+    if (fd < 0) {
+        return -1;
+    }
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) < 0)    {
+        CALIBRATION_PRINT("add_fd: epoll_ctl(%d) Error[%d]\n", fd, errno);
+        return -1;
+    }
+    return 0;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       event input and convert (main loop)
+ *              input devices of all touchpanels are waited by one epoll
+ *
+ * @param       nothing
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+static void
+event_iterate(void)
+{
+    int         epfd;
+    int         nev;
+    int         jj;
+    int         ii;
+    int         infd;
+    int         cffd;
+    int         changed;
+    int         downtime;
+    char        inbuf[4096];
+    struct epoll_event  ev_ret[4];
+    struct signalfd_siginfo siginfo;
+    struct timespec now, start;
+    calibration_panel   *panel;
+
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0)   {
+        CALIBRATION_PRINT("event_iterate: epoll_create Error[%d]\n", errno);
+        return;
+    }
+    infd = hotplug_init();
+    add_fd(epfd, infd);
+    cffd = config_watch();
+    add_fd(epfd, cffd);
+    add_fd(epfd, mSigFd);
+    for (ii = 0; ii < mPanelNum; ii++)  {
+        panel = &mPanels[ii];
+        add_fd(epfd, panel->evfd);
+        ioctl(panel->evfd, EVIOCGRAB, 1);
+        set_eventmask(panel);
+        set_eventclock(panel->evfd);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while (mRunning > 0) {
+        /* no timeout, wakes up only for input, hotplug or signal   */
+        nev = epoll_wait(epfd, ev_ret, sizeof(ev_ret)/sizeof(ev_ret[0]), -1);
+        if (mDumpLatency)   {
+            mDumpLatency = 0;
+            dump_latency();
+        }
+        if (mReleaseRequest)    {
+            mReleaseRequest = 0;
+            release_panels(epfd, ! mCalibrating);
+        }
+        if (mReloadConfig)  {
+            mReloadConfig = 0;
+            reload_program(epfd, 0);
+        }
+        if (nev <= 0) {
             continue;
         }
-        if (FD_ISSET(evfd, &fds)) {
-            rsize = read(evfd, events, sizeof(events));
-            if (rsize <= 0) {
-                if (rsize < 0)  {
-                    CALIBRATION_PRINT("event_iterate: input device(%d) end<%d>\n", evfd, errno);
-                    retry ++;
-                    if (retry > CALIBRATOIN_RETRY_COUNT)    {
-                        return;
+        for (jj = 0; jj < nev; jj++)    {
+            if ((mSigFd >= 0) && (ev_ret[jj].data.fd == mSigFd))    {
+                if (read(mSigFd, &siginfo, sizeof(siginfo)) == sizeof(siginfo))   {
+                    CALIBRATION_DEBUG("event_iterate: signal(%d)\n", (int)siginfo.ssi_signo);
+                    if (siginfo.ssi_signo == SIGUSR1)   {
+                        /* runtime dump, continue       */
+                        dump_latency();
+                        continue;
                     }
+                    if (siginfo.ssi_signo == SIGUSR2)   {
+                        /* release(or grab) for calibration tool    */
+                        release_panels(epfd, ! mCalibrating);
+                        continue;
+                    }
+                    if (siginfo.ssi_signo == SIGHUP)    {
+                        /* reload configuration, continue   */
+                        reload_program(epfd, 0);
+                        continue;
+                    }
+                    mRunning = - (int)siginfo.ssi_signo;
+                }
+                break;
+            }
+            if ((cffd >= 0) && (ev_ret[jj].data.fd == cffd))    {
+                /* configuration file is written(calibration tool)  */
+                changed = config_changed(cffd);
+                if (changed != 0)   {
+                    reload_program(epfd, (changed & IN_MOVED_TO) ? 1 : 0);
                 }
-                usleep(CALIBRATOIN_RETRY_WAIT * 1000);
                 continue;
             }
-            retry = 0;
-            for (ii = 0; ii < (int)(rsize/sizeof(struct input_event)); ii++) {
-                ret = calibration_event(&events[ii], &event);
-#ifdef  REPLACE_TOUCH_EVENT
-                if (ret >= 0)   {
-                    if (write(uifd, &event, sizeof(struct input_event)) < 0)    {
-                        CALIBRATION_PRINT("%s: Event write error %d[%d]\n",
-                                          CALIBDAE_DEV_NAME, uifd, errno);
-                    }
-                    if (mEventLog == 2) {
-                        push_event(&event);
+            if ((infd >= 0) && (ev_ret[jj].data.fd == infd))    {
+                /* hotplug, only need to know that the directory changed    */
+                while (read(infd, inbuf, sizeof(inbuf)) > 0)    ;
+                for (ii = 0; (! mCalibrating) && (ii < mPanelNum); ii++)  {
+                    panel = &mPanels[ii];
+                    if (panel->evfd >= 0)   continue;
+                    if (grab_panel(epfd, panel) >= 0)   {
+                        clock_gettime(CLOCK_MONOTONIC, &now);
+                        downtime = (now.tv_sec - panel->lost.tv_sec) * 1000 +
+                                   (now.tv_nsec - panel->lost.tv_nsec) / 1000000;
+                        mReconnect ++;
+                        mDowntime += downtime;
+                        CALIBRATION_PRINT("%s: input device reconnected(%d) downtime=%dms\n",
+                                          panel->name, panel->evfd, downtime);
                     }
-                    if (ret > 0)   {
-                        event.type = EV_SYN;
-                        event.code = SYN_REPORT;
-                        event.value = 0;
-                        write(uifd, &event, sizeof(struct input_event));
-
-                        event.type = EV_KEY;
-                        event.code = BTN_LEFT;
-                        event.value = 1;
-                        if (write(uifd, &event, sizeof(struct input_event)) < 0)    {
-                            CALIBRATION_PRINT("%s: Event write error %d[%d]\n",
-                                              CALIBDAE_DEV_NAME, uifd, errno);
-                        }
-                        else    {
-                            CALIBRATION_DEBUG("EV_KEY=BTN_LEFT\n");
-                        }
-                        if (mEventLog == 2) {
-                            push_event(&event);
-                        }
+                }
+                continue;
+            }
+            for (ii = 0; ii < mPanelNum; ii++)  {
+                panel = &mPanels[ii];
+                if ((panel->evfd >= 0) && (ev_ret[jj].data.fd == panel->evfd))  {
+                    if (event_panel(panel, infd) < 0)   {
+                        /* can not wait for reconnect   */
+                        mRunning = 0;
                     }
+                    break;
                 }
-#else  /*REPLACE_TOUCH_EVENT*/
-                ret = write(uifd, &event, sizeof(struct input_event));
-                if (mEventLog == 2) {
-                    push_event(&event);
+            }
+        }
+    }
+    close(epfd);
+    if (infd >= 0)  {
+        close(infd);
+    }
+    if (cffd >= 0)  {
+        close(cffd);
+    }
+    for (ii = 0; ii < mPanelNum; ii++)  {
+        if (mPanels[ii].evfd >= 0)  {
+            ioctl(mPanels[ii].evfd, EVIOCGRAB, 0);
+        }
+    }
+    if (mReconnect > 0) {
+        CALIBRATION_PRINT("%s: reconnect=%d downtime=%dms\n",
+                          CALIBDAE_DEV_NAME, mReconnect, mDowntime);
+    }
+    if (mOverflow > 0)  {
+        CALIBRATION_PRINT("%s: event buffer overflow=%d\n",
+                          CALIBDAE_DEV_NAME, mOverflow);
+    }
+    /* latency ends at write(uinput), it does not include the read of Weston */
+    CALIBRATION_PRINT("%s: panel=%d event clock=%s\n",
+                      CALIBDAE_DEV_NAME, mPanelNum,
+                      (mEventClock == CLOCK_MONOTONIC) ? "monotonic" : "realtime");
+    dump_latency();
+    if (mCoalesce)  {
+        /* coalesced frames per input frames(x100)  */
+        ii = (mInFrameCount > 0) ? (mCoalesced * 10000 / mInFrameCount) : 0;
+        CALIBRATION_PRINT("%s: coalesced=%d/%d frame(s) ratio=%d.%02d%%\n",
+                          CALIBDAE_DEV_NAME, mCoalesced, mInFrameCount, ii / 100, ii % 100);
+    }
+    if ((mFilter) || (mStationary)) {
+        CALIBRATION_PRINT("%s: filter suppressed=%d event(s)\n",
+                          CALIBDAE_DEV_NAME, mSuppressed);
+    }
+    /* wakeups per second(x100), compare with -n option */
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    downtime = (now.tv_sec - start.tv_sec) * 1000 +
+               (now.tv_nsec - start.tv_nsec) / 1000000;
+    if (downtime <= 0)  downtime = 1;
+    ii = (int)(((long long)mWakeup * 100000LL) / downtime);
+    CALIBRATION_PRINT("%s: wakeup=%d wakeup/s=%d.%02d(%ds) kernel filter=%s\n",
+                      CALIBDAE_DEV_NAME, mWakeup, ii / 100, ii % 100,
+                      downtime / 1000, mMask ? "on" : "off");
+    /* write system calls per frame(x100), was one write per event  */
+    ii = (mFrameCount > 0) ? (mWriteCount * 100 / mFrameCount) : 0;
+    CALIBRATION_PRINT("%s: frame=%d event=%d write=%d write/frame=%d.%02d\n",
+                      CALIBDAE_DEV_NAME, mFrameCount, mEventCount, mWriteCount,
+                      ii / 100, ii % 100);
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       read and convert events of a touchpanel
+ *
+ * @param[in,out] panel     touchpanel(input device is readable)
+ * @param[in]   infd        inotify file descriptor(< 0: no hotplug)
+ * @return      result
+ * @retval      0           sucess(or disconnected, wait for reconnect)
+ * @retval      -1          disconnected, can not wait for reconnect
+ */
+/*--------------------------------------------------------------------------*/
+static int
+event_panel(calibration_panel *panel, int infd)
+{
+    int         ret;
+    int         rsize;
+    int         ii;
+    int         last;
+    unsigned long long  readtime;
+    struct input_event  events[128];
+    struct input_event  event;
+
+    mWakeup ++;
+    rsize = read(panel->evfd, events, sizeof(events));
+    readtime = ico_ictl_latency_now();
+    if (rsize <= 0) {
+        if (rsize < 0)  {
+            CALIBRATION_PRINT("event_panel: input device(%d) end<%d>\n", panel->evfd, errno);
+            panel->retry ++;
+            if ((errno == ENODEV) || (panel->retry > CALIBRATOIN_RETRY_COUNT))  {
+                if (infd < 0)   {
+                    return -1;
                 }
-#endif /*REPLACE_TOUCH_EVENT*/
+                /* device unplugged, release button and wait reconnect  */
+                close_panel(panel);
+                return 0;
+            }
+        }
+        usleep(CALIBRATOIN_RETRY_WAIT * 1000);
+        return 0;
+    }
+    panel->retry = 0;
+    last = -1;
+    if (mCoalesce)  {
+        /* frames before the last one in this read may be coalesced */
+        for (ii = (int)(rsize/sizeof(struct input_event)) - 1; ii >= 0; ii--)  {
+            if ((events[ii].type == EV_SYN) && (events[ii].code == SYN_REPORT)) {
+                last = ii;
+                break;
+            }
+        }
+    }
+    for (ii = 0; ii < (int)(rsize/sizeof(struct input_event)); ii++) {
+        if ((events[ii].type == EV_SYN) && (events[ii].code == SYN_DROPPED))  {
+            /* kernel buffer overflowed, current frame is incomplete */
+            CALIBRATION_DEBUG("event_panel: SYN_DROPPED\n");
+            mOverflow ++;
+            panel->dropping = 1;
+            panel->nframe = 0;
+            panel->split = 0;
+            panel->key = 0;
+            continue;
+        }
+        if (panel->dropping)  {
+            /* ignore events until SYN_REPORT, then output the  */
+            /* current state of input device as one frame       */
+            if ((events[ii].type == EV_SYN) && (events[ii].code == SYN_REPORT)) {
+                panel->dropping = 0;
+                panel->nframe = resync_frame(panel, panel->frame, &events[ii].time);
+                write_frame(panel, panel->frame, &panel->nframe);
             }
+            continue;
+        }
+        if (events[ii].type == EV_KEY)  {
+            panel->key = 1;
+        }
+        ret = calibration_event(panel, &events[ii], &event);
+        if (panel->nframe > (CALIBRATOIN_FRAME_NUM - 5 - (panel->multitouch * 4)))  {
+            /* frame too long, write out before overflow    */
+            write_frame(panel, panel->frame, &panel->nframe);
+            panel->split = 1;
+        }
+        if ((events[ii].type == EV_SYN) && (events[ii].code == SYN_REPORT)) {
+            mInFrameCount ++;
+            ico_ictl_latency_add(&mLatRead, EVENT_USEC(events[ii].time), readtime);
+            if ((ii < last) && (! panel->split) && (motion_only(panel)))    {
+                /* newer frame follows in this read, the position   */
+                /* is output with it                                */
+                mCoalesced ++;
+                continue;
+            }
+            panel->key = 0;
+            /* position of this frame, before SYN_REPORT    */
+            panel->nframe += touch_frame(panel, &panel->frame[panel->nframe],
+                                         &events[ii].time);
+            if (panel->multitouch > 0)  {
+                panel->nframe += multitouch_frame(panel, &panel->frame[panel->nframe],
+                                                  &events[ii].time);
+            }
+            if ((mStationary) && (panel->nframe == 0) && (! panel->split))  {
+                /* nothing changed in this frame, no output */
+                mSuppressed ++;
+                continue;
+            }
+            panel->split = 0;
+        }
+        if (ret >= 0)   {
+            panel->frame[panel->nframe++] = event;
+            if (mEventLog == 2) {
+                push_event(&event);
+            }
+        }
+        if ((events[ii].type == EV_SYN) && (events[ii].code == SYN_REPORT)) {
+            /* end of frame, write all events at once   */
+            write_frame(panel, panel->frame, &panel->nframe);
+        }
+    }
+    return 0;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       write output frame to uinput by one system call
+ *
+ * @param[in]   panel       touchpanel(output device)
+ * @param[in]   frame       output events
+ * @param[in,out] nframe    number of output events(cleared)
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+static void
+write_frame(calibration_panel *panel, struct input_event *frame, int *nframe)
+{
+    if (*nframe <= 0)   {
+        return;
+    }
+    if (write(panel->uifd, frame, sizeof(struct input_event) * (*nframe)) < 0)   {
+        CALIBRATION_PRINT("%s: Event write error %d[%d]\n",
+                          panel->name, panel->uifd, errno);
+    }
+    mWriteCount ++;
+    mEventCount += *nframe;
+    if ((frame[*nframe - 1].type == EV_SYN) && (frame[*nframe - 1].code == SYN_REPORT))   {
+        mFrameCount ++;
+        /* latency from input event to delivery to compositor   */
+        ico_ictl_latency_add(&mLatOutput, EVENT_USEC(frame[*nframe - 1].time),
+                             ico_ictl_latency_now());
+    }
+    *nframe = 0;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       check multi-touch(protocol B) of input device
+ *
+ * @param[in]   panel       touchpanel
+ * @return      number of slot
+ * @retval      > 0         multi-touch device(number of slot)
+ * @retval      0           single touch device
+ */
+/*--------------------------------------------------------------------------*/
+static int
+check_multitouch(calibration_panel *panel)
+{
+    unsigned long       absbit[(ABS_CNT + (8 * sizeof(long)) - 1) / (8 * sizeof(long))];
+    struct input_absinfo absinfo;
+    int                 nslot;
+    int                 ii;
+
+    memset(absbit, 0, sizeof(absbit));
+    if (ioctl(panel->evfd, EVIOCGBIT(EV_ABS, sizeof(absbit)), absbit) < 0) {
+        return 0;
+    }
+    if (((absbit[ABS_MT_SLOT / (8 * sizeof(long))]
+          >> (ABS_MT_SLOT % (8 * sizeof(long)))) & 1) == 0)   {
+        return 0;
+    }
+    if (ioctl(panel->evfd, EVIOCGABS(ABS_MT_SLOT), &absinfo) < 0)  {
+        return 0;
+    }
+    nslot = absinfo.maximum + 1;
+    if (nslot > CALIBRATOIN_SLOT_NUM)   {
+        nslot = CALIBRATOIN_SLOT_NUM;
+    }
+    for (ii = 0; ii < CALIBRATOIN_SLOT_NUM; ii++)   {
+        panel->slots[ii].id = -1;
+        panel->slots[ii].changed = 0;
+    }
+    panel->slot = absinfo.value;
+    if ((panel->slot < 0) || (panel->slot >= nslot))    panel->slot = nslot;
+    CALIBRATION_DEBUG("check_multitouch: %d slots\n", nslot);
+    return nslot;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       make output events of changed contacts in a frame
+ *
+ * @param[in,out] panel     touchpanel
+ * @param[out]  frame       output events(max multitouch * 4)
+ * @param[in]   tp          time of frame
+ * @return      number of output events
+ */
+/*--------------------------------------------------------------------------*/
+static int
+multitouch_frame(calibration_panel *panel, struct input_event *frame,
+                 struct timeval *tp)
+{
+    calibration_slot    *slot;
+    int                 num = 0;
+    int                 npos = 0;
+    int                 rawx[CALIBRATOIN_SLOT_NUM], rawy[CALIBRATOIN_SLOT_NUM];
+    int                 x[CALIBRATOIN_SLOT_NUM], y[CALIBRATOIN_SLOT_NUM];
+    int                 move;
+    int                 ii;
+    unsigned long long  usec;
+
+#define MT_OUTPUT(c, v) \
+    {frame[num].time = *tp; frame[num].type = EV_ABS;   \
+     frame[num].code = (c); frame[num].value = (v); num++;}
+
+    /* calibrate X/Y of all moved contacts at once   */
+    usec = (unsigned long long)tp->tv_sec * 1000000ULL + tp->tv_usec;
+    for (ii = 0; ii < panel->multitouch; ii++)    {
+        slot = &panel->slots[ii];
+        if ((slot->id >= 0) && (slot->changed & MT_CHG_POS))    {
+            if (slot->changed & MT_CHG_ID)  {
+                /* new contact, filter starts at the touched position   */
+                calibration_filter_reset(&slot->fx);
+                calibration_filter_reset(&slot->fy);
+            }
+            rawx[npos] = slot->x;
+            rawy[npos] = slot->y;
+            if (mFilter)    {
+                rawx[npos] = calibration_filter_apply(&slot->fx, slot->x, usec);
+                rawy[npos] = calibration_filter_apply(&slot->fy, slot->y, usec);
+            }
+            npos ++;
+        }
+    }
+    if (npos > 0)   {
+        panel->matrix.batch(&panel->matrix, rawx, rawy, x, y, npos);
+    }
+    for (ii = 0; ii < npos; ii++)   {
+        /* region of this panel in the combined screen  */
+        x[ii] += panel->regionx;
+        y[ii] += panel->regiony;
+    }
+
+    npos = 0;
+    for (ii = 0; ii < panel->multitouch; ii++)    {
+        slot = &panel->slots[ii];
+        if (slot->changed == 0) continue;
+
+        move = -1;
+        if ((slot->id >= 0) && (slot->changed & MT_CHG_POS))    {
+            move = npos ++;
+            if ((mStationary) && ((slot->changed & MT_CHG_ID) == 0) &&
+                (x[move] == slot->outx) && (y[move] == slot->outy)) {
+                /* contact at rest, same position as last output    */
+                mSuppressed += 2;
+                move = -1;
+            }
+        }
+        if (((slot->changed & MT_CHG_ID) == 0) && (move < 0))  {
+            slot->changed = 0;
+            continue;
         }
+
+        if (panel->outslot != ii) {
+            MT_OUTPUT(ABS_MT_SLOT, ii);
+            panel->outslot = ii;
+        }
+        if (slot->changed & MT_CHG_ID)  {
+            MT_OUTPUT(ABS_MT_TRACKING_ID, slot->id);
+        }
+        if (move >= 0)  {
+            MT_OUTPUT(ABS_MT_POSITION_X, x[move]);
+            MT_OUTPUT(ABS_MT_POSITION_Y, y[move]);
+            slot->outx = x[move];
+            slot->outy = y[move];
+            CALIBRATION_DEBUG("MT slot=%d id=%d %d,%d=>%d,%d\n",
+                              ii, slot->id, slot->x, slot->y, x[move], y[move]);
+        }
+        slot->changed = 0;
     }
-    ioctl(evfd, EVIOCGRAB, 0);
+#undef  MT_OUTPUT
+    return num;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       set kernel event mask(EVIOCSMASK) of input device, only
+ *              codes which are converted or passed to uinput wake up
+ *
+ * @param[in]   panel       touchpanel
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+static void
+set_eventmask(calibration_panel *panel)
+{
+#ifdef  EVIOCSMASK
+    unsigned char       absmask[ABS_CNT / 8];
+    unsigned char       keymask[KEY_CNT / 8];
+    unsigned char       nonemask[REL_CNT / 8 + 1];
+    struct input_mask   mask;
+
+    if (! mMask)    {
+        return;
+    }
+    memset(absmask, 0, sizeof(absmask));
+    memset(keymask, 0, sizeof(keymask));
+    memset(nonemask, 0, sizeof(nonemask));
+
+#define SET_MASKBIT(array, bit) array[(bit) / 8] |= 1 << ((bit) % 8)
+    SET_MASKBIT(absmask, ABS_X);
+    SET_MASKBIT(absmask, ABS_Y);
+    if (panel->multitouch > 0)  {
+        SET_MASKBIT(absmask, ABS_MT_SLOT);
+        SET_MASKBIT(absmask, ABS_MT_TRACKING_ID);
+        SET_MASKBIT(absmask, ABS_MT_POSITION_X);
+        SET_MASKBIT(absmask, ABS_MT_POSITION_Y);
+    }
+    SET_MASKBIT(keymask, BTN_TOUCH);
+#ifdef  REPLACE_TOUCH_EVENT
+    SET_MASKBIT(keymask, BTN_LEFT);
+#else  /*REPLACE_TOUCH_EVENT*/
+    SET_MASKBIT(keymask, BTN_TOOL_PEN);
+#endif /*REPLACE_TOUCH_EVENT*/
+#undef  SET_MASKBIT
+
+    mask.type = EV_ABS;
+    mask.codes_size = sizeof(absmask);
+    mask.codes_ptr = (unsigned long)absmask;
+    if (ioctl(panel->evfd, EVIOCSMASK, &mask) < 0) {
+        /* old kernel, all events are read and ignored  */
+        CALIBRATION_DEBUG("set_eventmask: EVIOCSMASK not supported[%d]\n", errno);
+        return;
+    }
+    mask.type = EV_KEY;
+    mask.codes_size = sizeof(keymask);
+    mask.codes_ptr = (unsigned long)keymask;
+    ioctl(panel->evfd, EVIOCSMASK, &mask);
+
+    /* MSC_SCAN and relative(mouse mode of controller) are ignored  */
+    mask.codes_size = sizeof(nonemask);
+    mask.codes_ptr = (unsigned long)nonemask;
+    mask.type = EV_MSC;
+    ioctl(panel->evfd, EVIOCSMASK, &mask);
+    mask.type = EV_REL;
+    ioctl(panel->evfd, EVIOCSMASK, &mask);
+    CALIBRATION_DEBUG("set_eventmask: ABS_X/Y and touch button\n");
+#endif /*EVIOCSMASK*/
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       set clock of input event time(EVIOCSCLOCKID) to
+ *              CLOCK_MONOTONIC, latency is not changed by time adjustment
+ *
+ * @param[in]   evfd        event input file descriptor
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+static void
+set_eventclock(int evfd)
+{
+    int     clk = CLOCK_MONOTONIC;
+
+    mEventClock = CLOCK_REALTIME;
+#ifdef  EVIOCSCLOCKID
+    if (ioctl(evfd, EVIOCSCLOCKID, &clk) == 0)  {
+        mEventClock = CLOCK_MONOTONIC;
+        return;
+    }
+#endif /*EVIOCSCLOCKID*/
+    /* old kernel, latency is not measured  */
+    CALIBRATION_DEBUG("set_eventclock: EVIOCSCLOCKID not supported[%d]\n", errno);
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       release button and end multi-touch contacts of output device
+ *              (input device disconnected), in one frame
+ *
+ * @param[in,out] panel     touchpanel(output device)
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+static void
+release_button(calibration_panel *panel)
+{
+    struct input_event  event[CALIBRATOIN_SLOT_NUM * 2 + 2];
+    struct timespec     now;
+    struct timeval      tv;
+    int                 nevent = 0;
+    int                 ii;
+
+#define RELEASE_OUTPUT(t, c, v) \
+    {event[nevent].time = tv; event[nevent].type = (t);  \
+     event[nevent].code = (c); event[nevent].value = (v); nevent++;}
+
+    memset(event, 0, sizeof(event));
+    /* same clock as input events   */
+    clock_gettime(mEventClock, &now);
+    tv.tv_sec = now.tv_sec;
+    tv.tv_usec = now.tv_nsec / 1000;
+    for (ii = 0; ii < panel->multitouch; ii++)  {
+        /* contact of output, or changed in the discarded frame */
+        if ((panel->slots[ii].id >= 0) || (panel->slots[ii].changed & MT_CHG_ID))  {
+            RELEASE_OUTPUT(EV_ABS, ABS_MT_SLOT, ii);
+            RELEASE_OUTPUT(EV_ABS, ABS_MT_TRACKING_ID, -1);
+        }
+    }
+#ifdef  REPLACE_TOUCH_EVENT
+    RELEASE_OUTPUT(EV_KEY, BTN_LEFT, 0);
+#else  /*REPLACE_TOUCH_EVENT*/
+    RELEASE_OUTPUT(EV_KEY, BTN_TOUCH, 0);
+#endif /*REPLACE_TOUCH_EVENT*/
+    RELEASE_OUTPUT(EV_SYN, SYN_REPORT, 0);
+#undef  RELEASE_OUTPUT
+    write_frame(panel, event, &nevent);
 }
 
 static void
@@ -595,10 +1928,102 @@ push_event(struct input_event *ev)
     }
 }
 
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       get current position of touchpanel
+ *
+ * @param[in]   panel       touchpanel
+ * @return      nothing
+ */
+/*--------------------------------------------------------------------------*/
+static void
+get_position(calibration_panel *panel)
+{
+    struct input_absinfo absinfo;
+
+    if (ioctl(panel->evfd, EVIOCGABS(ABS_X), &absinfo) >= 0)   {
+        panel->rawx = absinfo.value;
+    }
+    if (ioctl(panel->evfd, EVIOCGABS(ABS_Y), &absinfo) >= 0)   {
+        panel->rawy = absinfo.value;
+    }
+    panel->poschanged = 0;
+    panel->touchdown = 0;
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       make output events of single touch position in a frame,
+ *              X and Y are converted at once by the calibration matrix
+ *
+ * @param[in,out] panel     touchpanel
+ * @param[out]  frame       output events(max 4)
+ * @param[in]   tp          time of frame
+ * @return      number of output events
+ */
+/*--------------------------------------------------------------------------*/
+static int
+touch_frame(calibration_panel *panel, struct input_event *frame,
+            struct timeval *tp)
+{
+    int     num = 0;
+    int     rawx, rawy;
+    int     x, y;
+    int     ii;
+    unsigned long long  usec;
+
+#define ST_OUTPUT(t, c, v)  \
+    {frame[num].time = *tp; frame[num].type = (t);   \
+     frame[num].code = (c); frame[num].value = (v); num++;}
+
+    if ((panel->poschanged) || (panel->touchdown))  {
+        rawx = panel->rawx;
+        rawy = panel->rawy;
+        if (mFilter)    {
+            usec = (unsigned long long)tp->tv_sec * 1000000ULL + tp->tv_usec;
+            rawx = calibration_filter_apply(&panel->filterx, panel->rawx, usec);
+            rawy = calibration_filter_apply(&panel->filtery, panel->rawy, usec);
+        }
+        panel->matrix.batch(&panel->matrix, &rawx, &rawy, &x, &y, 1);
+        x += panel->regionx;
+        y += panel->regiony;
+        if ((mStationary) && (! panel->touchdown) && (x == panel->outx) && (y == panel->outy))  {
+            /* finger at rest, same position as last output */
+            mSuppressed += 2;
+        }
+        else    {
+            ST_OUTPUT(EV_ABS, ABS_X, x);
+            ST_OUTPUT(EV_ABS, ABS_Y, y);
+            panel->outx = x;
+            panel->outy = y;
+        }
+        CALIBRATION_DEBUG("ABS_X/Y %d,%d=>%d,%d\n", panel->rawx, panel->rawy, x, y);
+        panel->poschanged = 0;
+    }
+#ifdef  REPLACE_TOUCH_EVENT
+    if (panel->touchdown) {
+        /* button is pressed after the position   */
+        ST_OUTPUT(EV_SYN, SYN_REPORT, 0);
+        ST_OUTPUT(EV_KEY, BTN_LEFT, 1);
+        CALIBRATION_DEBUG("EV_KEY=BTN_LEFT\n");
+        panel->touchdown = 0;
+    }
+#endif /*REPLACE_TOUCH_EVENT*/
+#undef  ST_OUTPUT
+
+    if (mEventLog == 2) {
+        for (ii = 0; ii < num; ii++)    {
+            push_event(&frame[ii]);
+        }
+    }
+    return num;
+}
+
 /*--------------------------------------------------------------------------*/
 /**
  * @brief       convert x/y coordinates
  *
+ * @param[in,out] panel     touchpanel
  * @param[in]   in          input event
  * @param[in]   out         output converted event
  * @return      result
@@ -608,12 +2033,10 @@ push_event(struct input_event *ev)
  */
 /*--------------------------------------------------------------------------*/
 static int
-calibration_event(struct input_event *in, struct input_event *out)
+calibration_event(calibration_panel *panel, struct input_event *in,
+                  struct input_event *out)
 {
     int     ret = 0;
-#ifdef  REPLACE_TOUCH_EVENT
-    static int queue_touch = 0;
-#endif /*REPLACE_TOUCH_EVENT*/
 
     memcpy(out, in, sizeof(struct input_event) );
 
@@ -621,73 +2044,59 @@ calibration_event(struct input_event *in, struct input_event *out)
     case EV_ABS:
         /* absolute coordinate      */
         switch (in->code) {
-            /* X/Y coordinate       */
+            /* X/Y coordinate, output at SYN_REPORT */
         case ABS_X:
-            out->value = mDispWidth * (in->value - mXlow) / (mXheigh - mXlow);
-            if (mRevX)  {
-                out->value = mDispWidth - out->value;
-            }
-            if (out->value < 0)             out->value = 0;
-            if (out->value >= mDispWidth)   out->value = mDispWidth - 1;
-
-            if (mTrans == 90)   {
-                out->code = ABS_Y;
-                out->value = mDispWidth - out->value - 1;
-            }
-            else if (mTrans == 180) {
-                out->value = mDispWidth - out->value - 1;
-            }
-            else if (mTrans == 270) {
-                out->code = ABS_Y;
-            }
+            panel->rawx = in->value;
+            panel->poschanged = 1;
             if (mEventLog == 1) {
                 push_eventlog("X", in->value, &(in->time));
             }
-#ifdef  REPLACE_TOUCH_EVENT
-            if (queue_touch & 1)    {
-                queue_touch &= ~1;
-                if (queue_touch == 0)   {
-                    ret = 1;
-                }
-            }
-#endif /*REPLACE_TOUCH_EVENT*/
-            CALIBRATION_DEBUG("ABS_X=%s %d=>%d\n",
-                              (out->code == ABS_X) ? "X" : "Y",
-                              in->value, out->value);
+            ret = -1;
             break;
 
         case ABS_Y:
-            out->value = mDispHeight * (in->value - mYlow) / (mYheigh - mYlow);
-            if (mRevY)  {
-                out->value = mDispHeight - out->value;
+            panel->rawy = in->value;
+            panel->poschanged = 1;
+            if (mEventLog == 1) {
+                push_eventlog("Y", in->value, &(in->time));
             }
-            if (out->value < 0)             out->value = 0;
-            if (out->value >= mDispHeight)  out->value = mDispHeight - 1;
+            ret = -1;
+            break;
 
-            if (mTrans == 90)   {
-                out->code = ABS_X;
+            /* multi-touch contact, output at SYN_REPORT    */
+        case ABS_MT_SLOT:
+            if ((in->value >= 0) && (in->value < panel->multitouch))  {
+                panel->slot = in->value;
             }
-            else if (mTrans == 180) {
-                out->value = mDispHeight - out->value - 1;
+            else    {
+                /* unsupported slot, its contact is ignored until next slot */
+                panel->slot = panel->multitouch;
             }
-            else if (mTrans == 270) {
-                out->code = ABS_X;
-                out->value = mDispHeight - out->value - 1;
+            ret = -1;
+            break;
+
+        case ABS_MT_TRACKING_ID:
+            if (panel->slot < panel->multitouch)    {
+                panel->slots[panel->slot].id = in->value;
+                panel->slots[panel->slot].changed |= MT_CHG_ID;
             }
-            if (mEventLog == 1) {
-                push_eventlog("Y", in->value, &(in->time));
+            ret = -1;
+            break;
+
+        case ABS_MT_POSITION_X:
+            if (panel->slot < panel->multitouch)    {
+                panel->slots[panel->slot].x = in->value;
+                panel->slots[panel->slot].changed |= MT_CHG_POS;
             }
-#ifdef  REPLACE_TOUCH_EVENT
-            if (queue_touch & 2)    {
-                queue_touch &= ~2;
-                if (queue_touch == 0)   {
-                    ret = 1;
-                }
+            ret = -1;
+            break;
+
+        case ABS_MT_POSITION_Y:
+            if (panel->slot < panel->multitouch)    {
+                panel->slots[panel->slot].y = in->value;
+                panel->slots[panel->slot].changed |= MT_CHG_POS;
             }
-#endif /*REPLACE_TOUCH_EVENT*/
-            CALIBRATION_DEBUG("ABS_Y=%s %d=>%d\n",
-                              (out->code == ABS_X) ? "X" : "Y",
-                              in->value, out->value);
+            ret = -1;
             break;
 
         default:
@@ -696,8 +2105,13 @@ calibration_event(struct input_event *in, struct input_event *out)
         }
         break;
 
-#ifdef  REPLACE_TOUCH_EVENT
     case EV_KEY:
+        if ((in->code == BTN_TOUCH) && (in->value != 0))    {
+            /* new contact, filter starts at the touched position   */
+            calibration_filter_reset(&panel->filterx);
+            calibration_filter_reset(&panel->filtery);
+        }
+#ifdef  REPLACE_TOUCH_EVENT
         if (in->code == BTN_TOUCH)  {
             if (mEventLog == 1) {
                 push_eventlog("Touch", in->value, &(in->time));
@@ -705,17 +2119,23 @@ calibration_event(struct input_event *in, struct input_event *out)
             /* Touch event change to mouse left button event    */
             out->code = BTN_LEFT;
             if (out->value != 0)    {
-                queue_touch = 3;
+                /* pressed at SYN_REPORT after the position */
+                panel->touchdown = 1;
                 ret = -1;
                 CALIBRATION_DEBUG("BTN_TOUCH=LEFT, queue(%d)\n", out->value);
             }
+            else if (panel->touchdown)    {
+                /* released in the same frame, nothing to output    */
+                panel->touchdown = 0;
+                ret = -1;
+            }
             else    {
                 ret = 0;
                 CALIBRATION_DEBUG("BTN_TOUCH=LEFT(%d)\n", out->value);
             }
         }
-        break;
 #endif /*REPLACE_TOUCH_EVENT*/
+        break;
 
     case EV_SYN:
         CALIBRATION_DEBUG("calibration_event: SYN\n");
@@ -737,16 +2157,26 @@ calibration_event(struct input_event *in, struct input_event *out)
  * @brief       setup uinput device for event output
  *
  * @param[in]   uinputDeviceName        uinput device node name
+ * @param[in]   panel                   touchpanel(input device and name)
  * @return      uinput file descriptor
  * @retval      >= 0    file descriptor
  * @retval      < 0     error
  */
 /*--------------------------------------------------------------------------*/
 static int
-setup_uinput(char *uinputDeviceName)
+setup_uinput(char *uinputDeviceName, calibration_panel *panel)
 {
+    static const int    abscode[] = { ABS_X, ABS_Y, ABS_MT_SLOT, ABS_MT_TRACKING_ID,
+                                      ABS_MT_POSITION_X, ABS_MT_POSITION_Y };
     int     uifd;
+    int     nabs;
+    int     ii;
+    struct input_absinfo    absinfo;
     struct uinput_user_dev  uinputDevice;
+#ifdef  UI_DEV_SETUP
+    struct uinput_setup     setup;
+    struct uinput_abs_setup abssetup;
+#endif /*UI_DEV_SETUP*/
 
     uifd = open_uinput(uinputDeviceName);
     if (uifd < 0)   {
@@ -754,21 +2184,51 @@ setup_uinput(char *uinputDeviceName)
         return -1;
     }
 
-    memset(&uinputDevice, 0, sizeof(uinputDevice));
-    strcpy(uinputDevice.name, CALIBDAE_DEV_NAME);
-    uinputDevice.absmax[ABS_X] = mDispWidth;
-    uinputDevice.absmax[ABS_Y] = mDispHeight;
-
-    /* uinput device configuration  */
-    if (write(uifd, &uinputDevice, sizeof(uinputDevice)) < (int)sizeof(uinputDevice)) {
-        perror("Regist uinput");
-        CALIBRATION_PRINT("setup_uinput: write(%d) Error[%d]\n", uifd, errno);
-        close(uifd);
-        return -1;
-    }
-
     /* uinput set event bits        */
-    set_eventbit(uifd);
+    set_eventbit(uifd, panel);
+
+    /* multi-touch codes only for multi-touch device    */
+    nabs = (panel->multitouch > 0) ? (int)(sizeof(abscode)/sizeof(abscode[0])) : 2;
+
+#ifdef  UI_DEV_SETUP
+    /* uinput device configuration(Linux 4.5 or later)  */
+    memset(&setup, 0, sizeof(setup));
+    snprintf(setup.name, sizeof(setup.name), "%s", panel->name);
+    if (ioctl(uifd, UI_DEV_SETUP, &setup) >= 0) {
+        for (ii = 0; ii < nabs; ii++)   {
+            memset(&abssetup, 0, sizeof(abssetup));
+            abssetup.code = abscode[ii];
+            get_absinfo(panel, abscode[ii], &abssetup.absinfo);
+            if (ioctl(uifd, UI_ABS_SETUP, &abssetup) < 0)   {
+                CALIBRATION_PRINT("setup_uinput: ioctl(%d,UI_ABS_SETUP,%d) Error[%d]\n",
+                                  uifd, abscode[ii], errno);
+            }
+        }
+        nabs = 0;
+    }
+    else    {
+        CALIBRATION_DEBUG("setup_uinput: UI_DEV_SETUP not supported[%d]\n", errno);
+    }
+#endif /*UI_DEV_SETUP*/
+
+    if (nabs > 0)   {
+        /* old kernel, uinput device configuration by write(no resolution) */
+        memset(&uinputDevice, 0, sizeof(uinputDevice));
+        snprintf(uinputDevice.name, sizeof(uinputDevice.name), "%s", panel->name);
+        for (ii = 0; ii < nabs; ii++)   {
+            get_absinfo(panel, abscode[ii], &absinfo);
+            uinputDevice.absmin[abscode[ii]] = absinfo.minimum;
+            uinputDevice.absmax[abscode[ii]] = absinfo.maximum;
+            uinputDevice.absfuzz[abscode[ii]] = absinfo.fuzz;
+            uinputDevice.absflat[abscode[ii]] = absinfo.flat;
+        }
+        if (write(uifd, &uinputDevice, sizeof(uinputDevice)) < (int)sizeof(uinputDevice)) {
+            perror("Regist uinput");
+            CALIBRATION_PRINT("setup_uinput: write(%d) Error[%d]\n", uifd, errno);
+            close(uifd);
+            return -1;
+        }
+    }
 
     if (ioctl(uifd, UI_DEV_CREATE, NULL) < 0)   {
         CALIBRATION_PRINT("setup_uinput: ioclt(%d,UI_DEV_CREATE,) Error[%d]\n", uifd, errno);
@@ -776,22 +2236,90 @@ setup_uinput(char *uinputDeviceName)
     return uifd;
 }
 
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       get absolute axis information of output device
+ *              range is the combined screen of all panels(after rotation),
+ *              resolution(units/mm) is that of input device scaled by the
+ *              calibration matrix
+ *
+ * @param[in]   panel       touchpanel
+ * @param[in]   code        code of absolute axis(ABS_xxx)
+ * @param[out]  absinfo     axis information
+ * @return      result
+ * @retval      0           sucess
+ * @retval      -1          code is not output
+ */
+/*--------------------------------------------------------------------------*/
+static int
+get_absinfo(calibration_panel *panel, int code, struct input_absinfo *absinfo)
+{
+    struct input_absinfo rawx, rawy;
+    long long           ax, ay;
+
+    /* fuzz and flat are 0, coordinates are already filtered   */
+    memset(absinfo, 0, sizeof(struct input_absinfo));
+    switch (code)   {
+    case ABS_X:
+    case ABS_MT_POSITION_X:
+        absinfo->maximum = mScreenWidth - 1;
+        ax = panel->matrix.a;
+        ay = panel->matrix.b;
+        break;
+    case ABS_Y:
+    case ABS_MT_POSITION_Y:
+        absinfo->maximum = mScreenHeight - 1;
+        ax = panel->matrix.d;
+        ay = panel->matrix.e;
+        break;
+    case ABS_MT_SLOT:
+        absinfo->maximum = panel->multitouch - 1;
+        return 0;
+    case ABS_MT_TRACKING_ID:
+        absinfo->maximum = 65535;
+        return 0;
+    default:
+        return -1;
+    }
+
+    memset(&rawx, 0, sizeof(rawx));
+    memset(&rawy, 0, sizeof(rawy));
+    ioctl(panel->evfd, EVIOCGABS(ABS_X), &rawx);
+    ioctl(panel->evfd, EVIOCGABS(ABS_Y), &rawy);
+    ax = ((ax < 0) ? -ax : ax) * rawx.resolution;
+    ay = ((ay < 0) ? -ay : ay) * rawy.resolution;
+    absinfo->resolution = (int)(((ax > ay) ? ax : ay) >> CALIBRATOIN_MATRIX_SHIFT);
+    return 0;
+}
+
 /*--------------------------------------------------------------------------*/
 /**
  * @brief       event bit set
  *
  * @param[in]   uifd        uinput file descriptor
+ * @param[in]   panel       touchpanel
  * @return      nothing
  */
 /*--------------------------------------------------------------------------*/
 static void
-set_eventbit(int uifd)
+set_eventbit(int uifd, calibration_panel *panel)
 {
+#ifdef  UI_SET_PROPBIT
+    /* touchpanel on the screen, coordinates are screen pixels  */
+    ioctl(uifd, UI_SET_PROPBIT, INPUT_PROP_DIRECT);
+#endif /*UI_SET_PROPBIT*/
+
     ioctl(uifd, UI_SET_EVBIT, EV_SYN);
 
     ioctl(uifd, UI_SET_EVBIT, EV_ABS);
     ioctl(uifd, UI_SET_ABSBIT, ABS_X);
     ioctl(uifd, UI_SET_ABSBIT, ABS_Y);
+    if (panel->multitouch > 0)  {
+        ioctl(uifd, UI_SET_ABSBIT, ABS_MT_SLOT);
+        ioctl(uifd, UI_SET_ABSBIT, ABS_MT_TRACKING_ID);
+        ioctl(uifd, UI_SET_ABSBIT, ABS_MT_POSITION_X);
+        ioctl(uifd, UI_SET_ABSBIT, ABS_MT_POSITION_Y);
+    }
 
     ioctl(uifd, UI_SET_EVBIT, EV_KEY);
 #ifdef  REPLACE_TOUCH_EVENT
@@ -850,6 +2378,158 @@ close_uinput(int uifd)
 static void
 print_usage(const char *pName)
 {
-    fprintf(stderr, "Usage: %s [-h][-d][-t [rotate]] [device]\n", pName );
+    fprintf(stderr, "Usage: %s [-h][-d][-t [rotate]][-x][-y][-n][-c] [device]\n", pName );
+    fprintf(stderr, "       -x/-y: mirror X/Y coordinate(after rotate)\n");
+    fprintf(stderr, "       -n: no kernel filter of unused events(to compare wakeups)\n");
+    fprintf(stderr, "       -c: output only the newest motion of a read\n");
+    fprintf(stderr, "       device: event device of the first panel, [PANEL] sections of\n");
+    fprintf(stderr, "               config file add panels(%s=, %s=X*Y)\n",
+            CALIBRATOIN_STR_DEVICE, CALIBRATOIN_STR_REGION);
+    fprintf(stderr, "       SIGUSR1: print latency(p50/p99/p99.9) of input events\n");
+    fprintf(stderr, "                (event time to write/flush of this daemon only)\n");
+    fprintf(stderr, "       SIGHUP: reload calibration of config file(also when written)\n");
+    fprintf(stderr, "       SIGUSR2: release input devices for calibration tool, grabbed\n");
+    fprintf(stderr, "                again when the tool replaces config file(or next SIGUSR2)\n");
+}
+
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       make output frame from current state of input device
+ *              (after SYN_DROPPED). the whole state is output, values
+ *              which are not changed are filtered by input core
+ *
+ * @param[in]   panel       touchpanel
+ * @param[out]  frame       output events(max multitouch * 4 + 7)
+ * @param[in]   tp          time of frame
+ * @return      number of output events
+ */
+/*--------------------------------------------------------------------------*/
+static int
+resync_frame(calibration_panel *panel, struct input_event *frame,
+             struct timeval *tp)
+{
+    unsigned long       keybit[(KEY_CNT + (8 * sizeof(long)) - 1) / (8 * sizeof(long))];
+    struct input_absinfo absinfo;
+    int                 num = 0;
+    int                 touch;
+    int                 ii;
+#ifdef  EVIOCGMTSLOTS
+    int                 req[CALIBRATOIN_SLOT_NUM + 1];
+#endif /*EVIOCGMTSLOTS*/
+
+#define KEY_STATE(bit)  \
+    ((keybit[(bit) / (8 * sizeof(long))] >> ((bit) % (8 * sizeof(long)))) & 1)
+#define RS_OUTPUT(t, c, v)  \
+    {frame[num].time = *tp; frame[num].type = (t);   \
+     frame[num].code = (c); frame[num].value = (v); num++;}
+
+    memset(keybit, 0, sizeof(keybit));
+    if (ioctl(panel->evfd, EVIOCGKEY(sizeof(keybit)), keybit) < 0) {
+        CALIBRATION_DEBUG("resync_frame: EVIOCGKEY Error[%d]\n", errno);
+    }
+    touch = KEY_STATE(BTN_TOUCH);
+
+    /* single touch position        */
+    get_position(panel);
+    panel->poschanged = 1;
+    calibration_filter_reset(&panel->filterx);
+    calibration_filter_reset(&panel->filtery);
+
+    /* multi-touch contacts         */
+    if (panel->multitouch > 0)  {
+        if (ioctl(panel->evfd, EVIOCGABS(ABS_MT_SLOT), &absinfo) >= 0) {
+            panel->slot = absinfo.value;
+            if ((panel->slot < 0) || (panel->slot >= panel->multitouch))  {
+                /* contact of unsupported slot is ignored  */
+                panel->slot = panel->multitouch;
+            }
+        }
+#ifdef  EVIOCGMTSLOTS
+        req[0] = ABS_MT_TRACKING_ID;
+        if (ioctl(panel->evfd, EVIOCGMTSLOTS(sizeof(req)), req) >= 0)  {
+            for (ii = 0; ii < panel->multitouch; ii++)    {
+                panel->slots[ii].id = req[ii + 1];
+                panel->slots[ii].changed = MT_CHG_ID;     /* also resets filter */
+            }
+            req[0] = ABS_MT_POSITION_X;
+            if (ioctl(panel->evfd, EVIOCGMTSLOTS(sizeof(req)), req) >= 0)  {
+                for (ii = 0; ii < panel->multitouch; ii++)    {
+                    panel->slots[ii].x = req[ii + 1];
+                }
+            }
+            req[0] = ABS_MT_POSITION_Y;
+            if (ioctl(panel->evfd, EVIOCGMTSLOTS(sizeof(req)), req) >= 0)  {
+                for (ii = 0; ii < panel->multitouch; ii++)    {
+                    panel->slots[ii].y = req[ii + 1];
+                }
+            }
+            for (ii = 0; ii < panel->multitouch; ii++)    {
+                if (panel->slots[ii].id >= 0) {
+                    panel->slots[ii].changed |= MT_CHG_POS;
+                }
+            }
+        }
+        else
+#endif /*EVIOCGMTSLOTS*/
+        {
+            /* slots can not be read, end all contacts  */
+            for (ii = 0; ii < panel->multitouch; ii++)    {
+                panel->slots[ii].id = -1;
+                panel->slots[ii].changed = MT_CHG_ID;
+            }
+        }
+    }
+
+#ifdef  REPLACE_TOUCH_EVENT
+    /* pressed button is output after the position by touch_frame */
+    panel->touchdown = touch;
+    num += touch_frame(panel, &frame[num], tp);
+    if (panel->multitouch > 0)  {
+        num += multitouch_frame(panel, &frame[num], tp);
+    }
+    if (! touch)    {
+        RS_OUTPUT(EV_KEY, BTN_LEFT, 0);
+    }
+#else  /*REPLACE_TOUCH_EVENT*/
+    num += touch_frame(panel, &frame[num], tp);
+    if (panel->multitouch > 0)  {
+        num += multitouch_frame(panel, &frame[num], tp);
+    }
+    RS_OUTPUT(EV_KEY, BTN_TOUCH, touch);
+    RS_OUTPUT(EV_KEY, BTN_TOOL_PEN, KEY_STATE(BTN_TOOL_PEN));
+#endif /*REPLACE_TOUCH_EVENT*/
+    RS_OUTPUT(EV_SYN, SYN_REPORT, 0);
+#undef  RS_OUTPUT
+#undef  KEY_STATE
+
+    CALIBRATION_DEBUG("resync_frame: touch=%d %d,%d events=%d\n",
+                      touch, panel->rawx, panel->rawy, num);
+    return num;
 }
 
+/*--------------------------------------------------------------------------*/
+/**
+ * @brief       check that the pending frame only moves contacts
+ *              (no touch-down, touch-up, button or new contact)
+ *
+ * @param[in]   panel       touchpanel(pending output events and key event)
+ * @return      result
+ * @retval      1           motion only
+ * @retval      0           frame must be output
+ */
+/*--------------------------------------------------------------------------*/
+static int
+motion_only(calibration_panel *panel)
+{
+    int     ii;
+
+    if ((panel->nframe > 0) || (panel->key) || (panel->touchdown))  {
+        return 0;
+    }
+    for (ii = 0; ii < panel->multitouch; ii++)    {
+        if (panel->slots[ii].changed & MT_CHG_ID) {
+            return 0;
+        }
+    }
+    return 1;
+}
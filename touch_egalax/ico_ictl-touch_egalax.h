@@ -28,6 +28,9 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/ioctl.h>
+#include <sys/inotify.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
 #include <linux/input.h>
 #include <linux/uinput.h>
 
@@ -50,11 +53,88 @@
 #define CALIBRATOIN_STR_POS2        "POSITION2"     /* Top-Right position       */
 #define CALIBRATOIN_STR_POS3        "POSITION3"     /* Bottom-Left position     */
 #define CALIBRATOIN_STR_POS4        "POSITION4"     /* Bottom-Right position    */
+#define CALIBRATOIN_STR_FLT_MIN     "FILTER_MINCUTOFF"  /* 1euro filter: min cutoff(Hz) */
+#define CALIBRATOIN_STR_FLT_BETA    "FILTER_BETA"       /* 1euro filter: speed coeff    */
+#define CALIBRATOIN_STR_FLT_DCUT    "FILTER_DCUTOFF"    /* 1euro filter: speed cutoff(Hz)*/
+#define CALIBRATOIN_STR_FLT_STAY    "FILTER_STATIONARY" /* suppress same position(1)    */
+#define CALIBRATOIN_STR_PANEL       "[PANEL]"       /* start of next touchpanel */
+#define CALIBRATOIN_STR_DEVICE      "DEVICE"        /* event device of panel    */
+#define CALIBRATOIN_STR_REGION      "REGION"        /* X*Y of region on screen  */
+#define CALIBRATOIN_STR_MATRIX      "MATRIX"        /* a*b*c*d*e*f of N-point fit   */
 
 /* Error retry              */
 #define CALIBRATOIN_RETRY_COUNT     10              /* number of error retry    */
 #define CALIBRATOIN_RETRY_WAIT      10              /* wait time(ms) for retry  */
 
+/* Output frame             */
+#define CALIBRATOIN_FRAME_NUM       64              /* max events in a frame    */
+#define CALIBRATOIN_SLOT_NUM        10              /* max multi-touch slots    */
+
+/* Touchpanels of a daemon  */
+#define CALIBRATOIN_PANEL_NUM       4               /* max touchpanels          */
+
+/* Hotplug                  */
+#define CALIBRATOIN_HOTPLUG_DIR     "/dev/input"    /* directory of device file */
+
+/* Affine calibration       */
+#define CALIBRATOIN_MATRIX_SHIFT    16              /* fraction bits of matrix  */
+
+/* Outlier rejection of N-point calibration(median absolute deviation)  */
+#define CALIBRATOIN_FIT_NUM         256             /* max points of robust fit */
+#define CALIBRATOIN_FIT_MADK        3.5             /* reject over K * sigma    */
+#define CALIBRATOIN_FIT_MINERR      1.0             /* min threshold(pixel)     */
+#define CALIBRATOIN_FIT_ITER        3               /* max number of refit      */
+
+/* Touches of a calibration point(calibration tool)     */
+#define CALIBRATOIN_TOUCH_MIN       3               /* touches before convergence   */
+#define CALIBRATOIN_TOUCH_MAX       8               /* max touches of a point   */
+#define CALIBRATOIN_TOUCH_CONVERGE  4               /* 95% interval of point(raw)   */
+#define CALIBRATOIN_POINT_MARGIN    10              /* margin of grid(% of screen)  */
+
+typedef struct  _calibration_matrix {
+    int     a, b, c;                    /* X = (a*x + b*y + c) >> SHIFT */
+    int     d, e, f;                    /* Y = (d*x + e*y + f) >> SHIFT */
+    int     width;                      /* screen width(after rotation) */
+    int     height;                     /* screen height(after rotation)*/
+                                        /* batch kernel for the matrix  */
+    void    (*batch)(const struct _calibration_matrix *matrix, const int *x,
+                     const int *y, int *outx, int *outy, int num);
+}   calibration_matrix;
+
+int calibration_fit(calibration_matrix *matrix, const int *rawx, const int *rawy,
+                    const int *dispx, const int *dispy, int num, int width, int height);
+int calibration_fit_robust(calibration_matrix *matrix, const int *rawx, const int *rawy,
+                           const int *dispx, const int *dispy, int num, int width,
+                           int height, int *inlier);
+void calibration_residual(const calibration_matrix *matrix, int x, int y,
+                          int dispx, int dispy, double *errx, double *erry);
+int calibration_stable(const int *value, int num, int limit);
+void calibration_point(int npoint, int index, int width, int height, int *x, int *y);
+void calibration_compose(calibration_matrix *matrix, int rotate, int mirrorx, int mirrory);
+void calibration_select(calibration_matrix *matrix);
+void calibration_apply(const calibration_matrix *matrix, int x, int y,
+                       int *outx, int *outy);
+void calibration_apply_batch(const calibration_matrix *matrix, const int *x, const int *y,
+                             int *outx, int *outy, int num);
+
+/* Jitter filter(1euro filter) of touchpanel coordinate    */
+#define CALIBRATOIN_FILTER_DCUTOFF  1.0             /* default speed cutoff(Hz) */
+
+typedef struct  _calibration_filter {
+    double  mincutoff;                  /* min cutoff frequency(Hz)     */
+    double  beta;                       /* cutoff increase by speed     */
+    double  dcutoff;                    /* cutoff frequency of speed(Hz)*/
+    double  value;                      /* filtered value               */
+    double  speed;                      /* filtered speed(unit/s)       */
+    unsigned long long  time;           /* time of value(us, 0: none)   */
+}   calibration_filter;
+
+void calibration_filter_init(calibration_filter *filter, double mincutoff,
+                             double beta, double dcutoff);
+void calibration_filter_reset(calibration_filter *filter);
+int calibration_filter_apply(calibration_filter *filter, int value,
+                             unsigned long long time);
+
 /* Debug macros             */
 #define CALIBRATION_DEBUG(fmt, ...) {if (mDebug) {fprintf(stdout, "%s:%d "fmt, __func__, __LINE__, ##__VA_ARGS__); fflush(stdout);}}
 #define CALIBRATION_INFO(fmt, ...)  {if (mDebug) {fprintf(stdout, "%s:%d "fmt, __func__, __LINE__, ##__VA_ARGS__); fflush(stdout);}}